@@ -0,0 +1,148 @@
+/*
+ *  Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+ *  SPDX-License-Identifier: MIT
+ *
+ *  Copyright (c) 2020-2022 Bhumit Attarde
+ *
+ *  Permission is hereby  granted, free of charge, to any  person obtaining a
+ * copy of this software and associated  documentation files (the "Software"),
+ * to deal in the Software  without restriction, including without  limitation
+ * the rights to  use, copy,  modify, merge,  publish, distribute,  sublicense,
+ * and/or  sell copies  of  the Software,  and  to  permit persons  to  whom the
+ * Software  is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS
+ * OR IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN
+ * NO EVENT  SHALL THE AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY
+ * CLAIM,  DAMAGES OR  OTHER LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT
+ * OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+namespace kiteconnect {
+
+namespace kc = kiteconnect;
+
+// `Price` changes the layout of `tick`, `depthWS` and every class that holds
+// them, so `KITE_FIXED_POINT_PRICES` has to be defined the same way in every
+// translation unit of a program. Mixing them is an ODR violation the linker
+// doesn't diagnose.
+#ifdef KITE_FIXED_POINT_PRICES
+///
+/// @brief Type prices are stored in.
+///
+/// `KITE_FIXED_POINT_PRICES` is defined, so prices are integers scaled by
+/// their segment's `priceScale()` (e.g., paise for equities), exactly as
+/// they're sent by Kite.
+///
+using Price = int64_t;
+#else
+///
+/// @brief Type prices are stored in.
+///
+/// Define `KITE_FIXED_POINT_PRICES` project-wide (e.g., with
+/// `-DKITE_FIXED_POINT_PRICES` for every translation unit) to store prices as
+/// integers scaled by their segment's `priceScale()` instead.
+///
+using Price = double;
+#endif
+
+namespace internal::segment {
+
+enum class SEGMENTS : uint8_t
+{
+    NSE = 1,
+    NFO,
+    CDS,
+    BSE,
+    BFO,
+    BSECDS,
+    MCX,
+    MCXSX,
+    INDICES
+};
+
+constexpr uint8_t MASK = 0xff;
+constexpr int64_t CDS_SCALE = 10000000;
+constexpr int64_t BSECDS_SCALE = 10000;
+constexpr int64_t GENERIC_SCALE = 100;
+
+/// Segment an instrument belongs to, held in the last byte of its token.
+inline constexpr uint8_t of(int64_t instrumentToken) {
+    // NOLINTNEXTLINE(hicpp-signed-bitwise)
+    return static_cast<uint8_t>(instrumentToken & MASK);
+}
+
+} // namespace internal::segment
+
+///
+/// @brief Factor prices of an instrument are scaled by.
+///
+/// @param instrumentToken instrument token of the instrument
+///
+/// @return int64_t `10000000` for CDS, `10000` for BSECDS and `100` for every
+///                 other segment
+///
+inline constexpr int64_t priceScale(int64_t instrumentToken) {
+    namespace segment = internal::segment;
+    const uint8_t seg = segment::of(instrumentToken);
+    if (seg == static_cast<uint8_t>(segment::SEGMENTS::CDS)) {
+        return segment::CDS_SCALE;
+    };
+    if (seg == static_cast<uint8_t>(segment::SEGMENTS::BSECDS)) {
+        return segment::BSECDS_SCALE;
+    };
+    return segment::GENERIC_SCALE;
+}
+
+///
+/// @brief Convert a decimal price of an instrument to `Price`.
+///
+/// With fixed point prices, the price is rounded to the nearest multiple of
+/// the instrument's smallest price unit.
+///
+inline Price toPrice(double value, int64_t instrumentToken) {
+#ifdef KITE_FIXED_POINT_PRICES
+    return std::llround(
+        value * static_cast<double>(priceScale(instrumentToken)));
+#else
+    static_cast<void>(instrumentToken);
+    return value;
+#endif
+}
+
+/// @brief Convert a `Price` of an instrument to a decimal price.
+inline constexpr double toDouble(Price price, int64_t instrumentToken) {
+#ifdef KITE_FIXED_POINT_PRICES
+    return static_cast<double>(price) /
+           static_cast<double>(priceScale(instrumentToken));
+#else
+    static_cast<void>(instrumentToken);
+    return price;
+#endif
+}
+
+namespace internal {
+
+/// `Price` of a scaled integer as sent by Kite, \a divisor being its scale.
+inline Price fromScaled(int32_t scaled, double divisor) {
+#ifdef KITE_FIXED_POINT_PRICES
+    static_cast<void>(divisor);
+    return scaled;
+#else
+    return scaled / divisor;
+#endif
+}
+
+} // namespace internal
+
+} // namespace kiteconnect
@@ -28,6 +28,7 @@
 #include <cstdint>
 #include <string>
 
+#include "../price.hpp"
 #include "../utils.hpp"
 #include "rapidcsv/src/rapidcsv.h"
 #include "rapidjson/include/rapidjson/document.h"
@@ -40,38 +41,53 @@ namespace rj = rapidjson;
 namespace kc = kiteconnect;
 namespace utils = kc::internal::utils;
 
+namespace internal {
+
+/// Get a price of \a instrumentToken, which decides the scale of fixed point
+/// prices.
+inline Price getPrice(
+    const rj::Value::Object& val, const char* name, int64_t instrumentToken) {
+    return kc::toPrice(utils::json::get<double>(val, name), instrumentToken);
+}
+
+} // namespace internal
+
 /// Represents OHLC information of an instrument.
 struct ohlc {
     ohlc() = default;
-    explicit ohlc(const rj::Value::Object& val) { parse(val); };
+    explicit ohlc(const rj::Value::Object& val, int64_t instrumentToken = 0) {
+        parse(val, instrumentToken);
+    };
 
-    void parse(const rj::Value::Object& val) {
-        open = utils::json::get<double>(val, "open");
-        high = utils::json::get<double>(val, "high");
-        low = utils::json::get<double>(val, "low");
-        close = utils::json::get<double>(val, "close");
+    void parse(const rj::Value::Object& val, int64_t instrumentToken = 0) {
+        open = internal::getPrice(val, "open", instrumentToken);
+        high = internal::getPrice(val, "high", instrumentToken);
+        low = internal::getPrice(val, "low", instrumentToken);
+        close = internal::getPrice(val, "close", instrumentToken);
     };
 
-    double open = -1;
-    double high = -1;
-    double low = -1;
-    double close = -1;
+    Price open = -1;
+    Price high = -1;
+    Price low = -1;
+    Price close = -1;
 };
 
 /// Represents market depth of an instrument.
 struct depth {
     depth() = default;
-    explicit depth(const rj::Value::Object& val) { parse(val); };
+    explicit depth(const rj::Value::Object& val, int64_t instrumentToken = 0) {
+        parse(val, instrumentToken);
+    };
 
-    void parse(const rj::Value::Object& val) {
-        price = utils::json::get<double>(val, "price");
+    void parse(const rj::Value::Object& val, int64_t instrumentToken = 0) {
+        price = internal::getPrice(val, "price", instrumentToken);
         quantity = utils::json::get<int>(val, "quantity");
         orders = utils::json::get<int>(val, "orders");
     };
 
     int quantity = -1;
     int orders = 0;
-    double price = -1;
+    Price price = -1;
 };
 
 /// Represents quote informating of an instrument.
@@ -82,24 +98,31 @@ struct quote {
     void parse(const rj::Value::Object& val) {
         instrumentToken = utils::json::get<uint32_t>(val, "instrument_token");
         timestamp = utils::json::get<string>(val, "timestamp");
-        lastPrice = utils::json::get<double>(val, "last_price");
+        lastPrice = internal::getPrice(val, "last_price", instrumentToken);
         lastQuantity = utils::json::get<int>(val, "last_quantity");
         lastTradeTime = utils::json::get<string>(val, "last_trade_time");
-        averagePrice = utils::json::get<double>(val, "average_price");
+        averagePrice =
+            internal::getPrice(val, "average_price", instrumentToken);
         volume = utils::json::get<int64_t>(val, "volume");
         buyQuantity = utils::json::get<int>(val, "buy_quantity");
         sellQuantity = utils::json::get<int>(val, "sell_quantity");
-        OHLC = utils::json::get<utils::json::JsonObject, ohlc>(val, "ohlc");
+        rj::Value ohlcVal(rj::kObjectType);
+        if (utils::json::get<utils::json::JsonObject>(val, ohlcVal, "ohlc")) {
+            OHLC.parse(ohlcVal.GetObject(), instrumentToken);
+        };
         netChange = utils::json::get<double>(val, "net_change");
         OI = utils::json::get<double>(val, "oi");
         OIDayHigh = utils::json::get<double>(val, "oi_day_high");
         OIDayLow = utils::json::get<double>(val, "oi_day_low");
         lowerCircuitLimit =
-            utils::json::get<double>(val, "lower_circuit_limit");
+            internal::getPrice(val, "lower_circuit_limit", instrumentToken);
         upperCircuitLimit =
-            utils::json::get<double>(val, "upper_circuit_limit");
-        marketDepth =
-            utils::json::get<utils::json::JsonObject, mDepth>(val, "depth");
+            internal::getPrice(val, "upper_circuit_limit", instrumentToken);
+        rj::Value depthVal(rj::kObjectType);
+        if (utils::json::get<utils::json::JsonObject>(
+                val, depthVal, "depth")) {
+            marketDepth.parse(depthVal.GetObject(), instrumentToken);
+        };
     };
 
     uint32_t instrumentToken = 0;
@@ -107,32 +130,35 @@ struct quote {
     int buyQuantity = -1;
     int sellQuantity = -1;
     int lastQuantity = -1;
-    double lastPrice = -1;
-    double averagePrice = -1;
+    Price lastPrice = -1;
+    Price averagePrice = -1;
     double netChange = -1;
     double OI = -1;
     double OIDayHigh = -1;
     double OIDayLow = -1;
-    double lowerCircuitLimit = -1;
-    double upperCircuitLimit = -1;
+    Price lowerCircuitLimit = -1;
+    Price upperCircuitLimit = -1;
     string timestamp;
     string lastTradeTime;
     ohlc OHLC;
     struct mDepth {
         mDepth() = default;
-        explicit mDepth(const rj::Value::Object& val) { parse(val); };
+        explicit mDepth(
+            const rj::Value::Object& val, int64_t instrumentToken = 0) {
+            parse(val, instrumentToken);
+        };
 
-        void parse(const rj::Value::Object& val) {
+        void parse(const rj::Value::Object& val, int64_t instrumentToken = 0) {
             rj::Value buyDepthVal(rj::kArrayType);
             utils::json::get<utils::json::JsonArray>(val, buyDepthVal, "buy");
             for (auto& i : buyDepthVal.GetArray()) {
-                buy.emplace_back(i.GetObject());
+                buy.emplace_back(i.GetObject(), instrumentToken);
             };
 
             rj::Value sellDepthVal(rj::kArrayType);
             utils::json::get<utils::json::JsonArray>(val, sellDepthVal, "sell");
             for (auto& i : sellDepthVal.GetArray()) {
-                sell.emplace_back(i.GetObject());
+                sell.emplace_back(i.GetObject(), instrumentToken);
             };
         }
 
@@ -148,12 +174,15 @@ struct ohlcQuote {
 
     void parse(const rj::Value::Object& val) {
         instrumentToken = utils::json::get<uint32_t>(val, "instrument_token");
-        lastPrice = utils::json::get<double>(val, "last_price");
-        OHLC = utils::json::get<utils::json::JsonObject, ohlc>(val, "ohlc");
+        lastPrice = internal::getPrice(val, "last_price", instrumentToken);
+        rj::Value ohlcVal(rj::kObjectType);
+        if (utils::json::get<utils::json::JsonObject>(val, ohlcVal, "ohlc")) {
+            OHLC.parse(ohlcVal.GetObject(), instrumentToken);
+        };
     };
 
     uint32_t instrumentToken = 0;
-    double lastPrice = -1;
+    Price lastPrice = -1;
     ohlc OHLC;
 };
 
@@ -164,11 +193,11 @@ struct ltpQuote {
 
     void parse(const rj::Value::Object& val) {
         instrumentToken = utils::json::get<uint32_t>(val, "instrument_token");
-        lastPrice = utils::json::get<double>(val, "last_price");
+        lastPrice = internal::getPrice(val, "last_price", instrumentToken);
     };
 
     uint32_t instrumentToken = 0;
-    double lastPrice = -1;
+    Price lastPrice = -1;
 };
 
 /// represents parameters required for the `getHistoricalData` function
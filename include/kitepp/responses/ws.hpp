@@ -25,9 +25,14 @@
 
 #pragma once
 
+#include <array>
+#include <cstddef>
 #include <cstdint>
 #include <string>
+#include <string_view>
+#include <type_traits>
 
+#include "../price.hpp"
 #include "../utils.hpp"
 #include "rapidjson/include/rapidjson/document.h"
 #include "rapidjson/include/rapidjson/rapidjson.h"
@@ -39,41 +44,63 @@ namespace kc = kiteconnect;
 namespace rj = rapidjson;
 namespace utils = kc::internal::utils;
 
+/// Mode a tick was received in.
+enum class TICK_MODE : uint8_t
+{
+    UNKNOWN,
+    LTP,
+    QUOTE,
+    FULL
+};
+
 /// Represents a single entry in market depth returned by `ticker`.
 struct depthWS {
-    int16_t orders = -1;
+    Price price = -1;
     int32_t quantity = -1;
-    double price = -1;
+    int16_t orders = -1;
 };
 
 /// Represents a single market data tick.
+///
+/// \note A tick holds no heap allocated members and is trivially copyable. The
+///       fields that are read most often are laid out in the first cache line.
 struct tick {
+    static constexpr size_t DEPTH_LEVELS = 5;
+
     int32_t instrumentToken = -1;
-    int32_t timestamp = -1;
-    int32_t lastTradeTime = -1;
+    TICK_MODE mode = TICK_MODE::UNKNOWN;
+    bool isTradable = false;
+    Price lastPrice = -1;
     int32_t lastTradedQuantity = -1;
+    int32_t volumeTraded = -1;
     int32_t totalBuyQuantity = -1;
     int32_t totalSellQuantity = -1;
-    int32_t volumeTraded = -1;
+    int32_t timestamp = -1;
+    int32_t lastTradeTime = -1;
     int32_t oi = -1;
     int32_t oiDayHigh = -1;
     int32_t oiDayLow = -1;
-    string mode;
-    double lastPrice = -1;
-    double averageTradePrice = -1;
+    Price averageTradePrice = -1;
+    /// change in percentage for tradable instruments, absolute for indices
     double netChange = -1;
-    bool isTradable;
     struct OHLC {
-        double open = -1;
-        double high = -1;
-        double low = -1;
-        double close = -1;
+        Price open = -1;
+        Price high = -1;
+        Price low = -1;
+        Price close = -1;
     } ohlc;
     struct m_depth {
-        std::vector<depthWS> buy;
-        std::vector<depthWS> sell;
+        std::array<depthWS, DEPTH_LEVELS> buy;
+        std::array<depthWS, DEPTH_LEVELS> sell;
+        /// number of valid entries in \a buy and \a sell (0 unless the tick
+        /// was received in full mode)
+        uint8_t count = 0;
     } marketDepth;
 };
+static_assert(std::is_trivially_copyable_v<tick>,
+    "tick must be trivially copyable");
+static_assert(offsetof(tick, averageTradePrice) + sizeof(Price) <= 64,
+    "frequently read tick fields must fit in a cache line");
 
 /// Represents a postback.
 struct postback {
@@ -127,4 +154,105 @@ struct postback {
     string checksum;
 };
 
+///
+/// Represents a postback without copying it.
+///
+/// Strings point into the received message and are only valid until the
+/// callback they're passed to returns. Fields that are missing or `null` are
+/// left empty (or `-1` for numbers).
+///
+struct postbackView {
+    postbackView() = default;
+    explicit postbackView(const rj::Value::Object& val) { parse(val); };
+
+    // members are visited once instead of being looked up one by one
+    // NOLINTNEXTLINE(readability-function-cognitive-complexity)
+    void parse(const rj::Value::Object& val) {
+        for (const auto& member : val) {
+            const std::string_view name(
+                member.name.GetString(), member.name.GetStringLength());
+            const rj::Value& value = member.value;
+            if (name == "order_id") {
+                orderId = view(value);
+            } else if (name == "exchange_order_id") {
+                exchangeOrderId = view(value);
+            } else if (name == "placed_by") {
+                placedBy = view(value);
+            } else if (name == "status") {
+                status = view(value);
+            } else if (name == "status_message") {
+                statusMessage = view(value);
+            } else if (name == "tradingsymbol") {
+                tradingSymbol = view(value);
+            } else if (name == "exchange") {
+                exchange = view(value);
+            } else if (name == "order_type") {
+                orderType = view(value);
+            } else if (name == "transaction_type") {
+                transactionType = view(value);
+            } else if (name == "validity") {
+                validity = view(value);
+            } else if (name == "product") {
+                product = view(value);
+            } else if (name == "average_price") {
+                averagePrice = number(value);
+            } else if (name == "price") {
+                price = number(value);
+            } else if (name == "quantity") {
+                quantity = integer(value);
+            } else if (name == "filled_quantity") {
+                filledQuantity = integer(value);
+            } else if (name == "unfilled_quantity") {
+                unfilledQuantity = integer(value);
+            } else if (name == "trigger_price") {
+                triggerPrice = number(value);
+            } else if (name == "user_id") {
+                userId = view(value);
+            } else if (name == "order_timestamp") {
+                orderTimestamp = view(value);
+            } else if (name == "exchange_timestamp") {
+                exchangeTimestamp = view(value);
+            } else if (name == "checksum") {
+                checksum = view(value);
+            };
+        };
+    };
+
+    int quantity = -1;
+    int filledQuantity = -1;
+    int unfilledQuantity = -1;
+    double averagePrice = -1;
+    double price = -1;
+    double triggerPrice = -1;
+    std::string_view orderId;
+    std::string_view exchangeOrderId;
+    std::string_view placedBy;
+    std::string_view status;
+    std::string_view statusMessage;
+    std::string_view tradingSymbol;
+    std::string_view exchange;
+    std::string_view orderType;
+    std::string_view transactionType;
+    std::string_view validity;
+    std::string_view product;
+    std::string_view userId;
+    std::string_view orderTimestamp;
+    std::string_view exchangeTimestamp;
+    std::string_view checksum;
+
+  private:
+    static std::string_view view(const rj::Value& value) {
+        if (!value.IsString()) { return {}; };
+        return { value.GetString(), value.GetStringLength() };
+    };
+
+    static double number(const rj::Value& value) {
+        return value.IsNumber() ? value.GetDouble() : -1;
+    };
+
+    static int integer(const rj::Value& value) {
+        return value.IsInt() ? value.GetInt() : -1;
+    };
+};
+
 } // namespace kiteconnect
\ No newline at end of file
@@ -25,5 +25,10 @@
 
 #pragma once
 
+#include "ticker/book.hpp"
+#include "ticker/candles.hpp"
 #include "ticker/internal.hpp"
+#include "ticker/redundant.hpp"
+#include "ticker/replay.hpp"
+#include "ticker/sharded.hpp"
 #include "ticker/ws.hpp"
\ No newline at end of file
@@ -0,0 +1,190 @@
+/*
+ *  Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+ *  SPDX-License-Identifier: MIT
+ *
+ *  Copyright (c) 2020-2022 Bhumit Attarde
+ *
+ *  Permission is hereby  granted, free of charge, to any  person obtaining a
+ * copy of this software and associated  documentation files (the "Software"),
+ * to deal in the Software  without restriction, including without  limitation
+ * the rights to  use, copy,  modify, merge,  publish, distribute,  sublicense,
+ * and/or  sell copies  of  the Software,  and  to  permit persons  to  whom the
+ * Software  is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS
+ * OR IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN
+ * NO EVENT  SHALL THE AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY
+ * CLAIM,  DAMAGES OR  OTHER LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT
+ * OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../responses/ws.hpp"
+#include "../utils.hpp"
+#include "depth.hpp"
+#include "packet.hpp"
+
+namespace kiteconnect {
+
+namespace kc = kiteconnect;
+
+///
+/// @brief Ticks of a frame stored column-wise (struct of arrays).
+///
+/// Row `i` of every column belongs to the `i`th packet of the frame. Columns
+/// are aligned to cache lines so they can be consumed directly by vectorised
+/// code. Like `tick`, fields that aren't sent in a packet's mode are `-1`. Only
+/// the best bid and offer of market depth are stored, `onTicks` should be used
+/// if the complete depth is required.
+///
+struct tickBatch {
+    static constexpr size_t ALIGNMENT = 64;
+    template <class T>
+    using column =
+        std::vector<T, internal::utils::alignedAllocator<T, ALIGNMENT>>;
+
+    /// @brief Number of ticks in the batch.
+    [[nodiscard]] size_t size() const { return instrumentToken.size(); };
+
+    [[nodiscard]] bool empty() const { return instrumentToken.empty(); };
+
+    /// @brief Remove all ticks, keeps the capacity of all columns.
+    void clear() {
+        forEachColumn([](auto& col) { col.clear(); });
+    };
+
+    void reserve(size_t capacity) {
+        forEachColumn([&](auto& col) { col.reserve(capacity); });
+    };
+
+    void resize(size_t count) {
+        forEachColumn([&](auto& col) { col.resize(count); });
+    };
+
+    ///
+    /// @brief Decode a packet into a row.
+    ///
+    /// @param row        row to decode the packet into
+    /// @param packet     start of the packet
+    /// @param packetSize size of the packet
+    ///
+    void assign(size_t row, const char* packet, size_t packetSize);
+
+    column<int32_t> instrumentToken;
+    column<TICK_MODE> mode;
+    column<uint8_t> isTradable;
+    column<Price> lastPrice;
+    column<int32_t> lastTradedQuantity;
+    column<Price> averageTradePrice;
+    column<int32_t> volumeTraded;
+    column<int32_t> totalBuyQuantity;
+    column<int32_t> totalSellQuantity;
+    column<Price> open;
+    column<Price> high;
+    column<Price> low;
+    column<Price> close;
+    column<double> netChange;
+    column<int32_t> timestamp;
+    column<int32_t> lastTradeTime;
+    column<int32_t> oi;
+    column<int32_t> oiDayHigh;
+    column<int32_t> oiDayLow;
+    /// best bid (first buy entry of market depth)
+    column<Price> bidPrice;
+    column<int32_t> bidQuantity;
+    /// best offer (first sell entry of market depth)
+    column<Price> askPrice;
+    column<int32_t> askQuantity;
+
+  private:
+    template <class Func>
+    void forEachColumn(Func&& func) {
+        func(instrumentToken);
+        func(mode);
+        func(isTradable);
+        func(lastPrice);
+        func(lastTradedQuantity);
+        func(averageTradePrice);
+        func(volumeTraded);
+        func(totalBuyQuantity);
+        func(totalSellQuantity);
+        func(open);
+        func(high);
+        func(low);
+        func(close);
+        func(netChange);
+        func(timestamp);
+        func(lastTradeTime);
+        func(oi);
+        func(oiDayHigh);
+        func(oiDayLow);
+        func(bidPrice);
+        func(bidQuantity);
+        func(askPrice);
+        func(askQuantity);
+    };
+};
+
+// NOLINTBEGIN(cppcoreguidelines-pro-bounds-constant-array-index)
+inline void tickBatch::assign(
+    size_t row, const char* packet, size_t packetSize) {
+    namespace pkt = internal::packet;
+    const auto quoteField = [&](size_t offset) {
+        return pkt::quoteField(packet, packetSize, offset);
+    };
+    const auto fullField = [&](size_t offset) {
+        return pkt::fullField(packet, packetSize, offset);
+    };
+
+    const bool hasToken = packetSize >= pkt::LTP_SIZE;
+    const int32_t token =
+        hasToken ? pkt::read<int32_t>(packet, pkt::INSTRUMENT_TOKEN) : -1;
+    const double divisor = pkt::divisor(token);
+    const bool isQuote = pkt::isQuote(packetSize);
+
+    instrumentToken[row] = token;
+    mode[row] = pkt::modeOf(packetSize);
+    isTradable[row] = static_cast<uint8_t>(hasToken && pkt::isTradable(token));
+    lastPrice[row] =
+        hasToken ? pkt::priceAt(packet, pkt::LAST_PRICE, divisor) : -1;
+
+    lastTradedQuantity[row] = quoteField(pkt::LAST_TRADED_QUANTITY);
+    averageTradePrice[row] =
+        isQuote ? pkt::priceAt(packet, pkt::AVERAGE_TRADE_PRICE, divisor) : -1;
+    volumeTraded[row] = quoteField(pkt::VOLUME_TRADED);
+    totalBuyQuantity[row] = quoteField(pkt::TOTAL_BUY_QUANTITY);
+    totalSellQuantity[row] = quoteField(pkt::TOTAL_SELL_QUANTITY);
+    const kc::tick::OHLC OHLC = pkt::ohlc(packet, packetSize, divisor);
+    open[row] = OHLC.open;
+    high[row] = OHLC.high;
+    low[row] = OHLC.low;
+    close[row] = OHLC.close;
+    netChange[row] = pkt::netChange(packet, packetSize, divisor);
+
+    timestamp[row] = pkt::timestamp(packet, packetSize);
+    lastTradeTime[row] = fullField(pkt::LAST_TRADE_TIME);
+    oi[row] = fullField(pkt::OI);
+    oiDayHigh[row] = fullField(pkt::OI_DAY_HIGH);
+    oiDayLow[row] = fullField(pkt::OI_DAY_LOW);
+
+    const depthWS bid = pkt::depthEntry(packet, packetSize, 0, divisor);
+    const depthWS ask = pkt::depthEntry(
+        packet, packetSize, kc::tick::DEPTH_LEVELS, divisor);
+    bidQuantity[row] = bid.quantity;
+    bidPrice[row] = bid.price;
+    askQuantity[row] = ask.quantity;
+    askPrice[row] = ask.price;
+};
+// NOLINTEND(cppcoreguidelines-pro-bounds-constant-array-index)
+
+} // namespace kiteconnect
@@ -0,0 +1,344 @@
+/*
+ *  Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+ *  SPDX-License-Identifier: MIT
+ *
+ *  Copyright (c) 2020-2022 Bhumit Attarde
+ *
+ *  Permission is hereby  granted, free of charge, to any  person obtaining a
+ * copy of this software and associated  documentation files (the "Software"),
+ * to deal in the Software  without restriction, including without  limitation
+ * the rights to  use, copy,  modify, merge,  publish, distribute,  sublicense,
+ * and/or  sell copies  of  the Software,  and  to  permit persons  to  whom the
+ * Software  is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS
+ * OR IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN
+ * NO EVENT  SHALL THE AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY
+ * CLAIM,  DAMAGES OR  OTHER LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT
+ * OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+#include "../price.hpp"
+#include "../responses/ws.hpp"
+
+namespace kiteconnect {
+
+namespace kc = kiteconnect;
+
+enum class DEPTH_SIDE : uint8_t
+{
+    BUY,
+    SELL
+};
+
+enum class DEPTH_CHANGE : uint8_t
+{
+    ADDED,
+    REMOVED,
+    MODIFIED
+};
+
+/// Represents a change of a single price level of an instrument's depth.
+struct depthChange {
+    int32_t instrumentToken = -1;
+    DEPTH_SIDE side = DEPTH_SIDE::BUY;
+    DEPTH_CHANGE change = DEPTH_CHANGE::ADDED;
+    /// position of the level in the new depth, in the old one if it was
+    /// removed
+    uint8_t level = 0;
+    Price price = -1;
+    /// quantity at the level, `0` if it was removed
+    int32_t quantity = 0;
+    int32_t quantityDelta = 0;
+    int16_t orders = 0;
+};
+
+/// Represents the best bid & ask of an instrument and metrics derived from
+/// them.
+struct topOfBook {
+    Price bidPrice = -1;
+    Price askPrice = -1;
+    int32_t bidQuantity = 0;
+    int32_t askQuantity = 0;
+    /// `askPrice - bidPrice`, `-1` unless both sides have a level
+    Price spread = -1;
+    /// mid price, `-1` unless both sides have a level
+    double mid = -1;
+    /// `(bidQuantity - askQuantity) / (bidQuantity + askQuantity)`, in [-1, 1]
+    double imbalance = 0;
+    /// total quantity of all buy levels
+    int64_t bidDepth = 0;
+    /// total quantity of all sell levels
+    int64_t askDepth = 0;
+};
+
+///
+/// \brief \a depthBook keeps the market depth of every instrument and reports
+///         how it changes with every full mode tick.
+///
+/// Levels are matched by price, so a level whose price moves shows up as one
+/// level removed & another added. Books are stored contiguously with their
+/// levels inline.
+///
+class depthBook {
+  public:
+    static constexpr size_t DEFAULT_CAPACITY = 3000;
+    static constexpr size_t LEVELS = kc::tick::DEPTH_LEVELS;
+
+    /// @brief Called with the changes caused by a call to `update()`, if there
+    ///        are any.
+    std::function<void(depthBook* book, const std::vector<kc::depthChange>&)>
+        onChanges;
+
+    ///
+    /// @brief Construct a new depth book.
+    ///
+    /// @param Capacity number of instruments storage is reserved for
+    ///
+    explicit depthBook(size_t Capacity = DEFAULT_CAPACITY);
+
+    ///
+    /// @brief Apply the depth of a tick. Ticks without depth (i.e., not in full
+    ///        mode) are ignored.
+    ///
+    /// @param Tick tick whose depth should be applied
+    ///
+    void update(const kc::tick& Tick);
+
+    ///
+    /// @brief Apply the depth of ticks, e.g., the ones passed to `onTicks`.
+    ///        Changes of all ticks are passed to `onChanges` together.
+    ///
+    /// @param ticks ticks whose depth should be applied
+    ///
+    void update(const std::vector<kc::tick>& ticks);
+
+    ///
+    /// @brief Get the depth of an instrument.
+    ///
+    /// @param instrumentToken instrument token of the instrument
+    /// @param depth           set to the latest depth of the instrument
+    ///
+    /// @return bool `false` if no depth has been received for the instrument
+    ///
+    bool getDepth(int32_t instrumentToken, kc::tick::m_depth& depth) const;
+
+    ///
+    /// @brief Get the best bid & ask of an instrument.
+    ///
+    /// @param instrumentToken instrument token of the instrument
+    /// @param top             set to the top of the instrument's book
+    ///
+    /// @return bool `false` if no depth has been received for the instrument
+    ///
+    bool getTopOfBook(int32_t instrumentToken, kc::topOfBook& top) const;
+
+    /// @brief Remove the depth of every instrument.
+    void clear();
+
+  private:
+    struct side {
+        std::array<Price, LEVELS> price {};
+        std::array<int32_t, LEVELS> quantity {};
+        std::array<int16_t, LEVELS> orders {};
+        uint8_t count = 0;
+    };
+
+    struct book {
+        int32_t instrumentToken = -1;
+        side buy;
+        side sell;
+        kc::topOfBook top;
+    };
+
+    std::vector<book> books;
+    std::unordered_map<int32_t, size_t> index;
+    std::vector<kc::depthChange> changes;
+
+    void apply(const kc::tick& Tick);
+
+    // replaces \a current with \a levels, appending the differences to
+    // `changes`, returns the change in total quantity
+    int64_t diff(int32_t instrumentToken, DEPTH_SIDE Side, side& current,
+        const std::array<kc::depthWS, LEVELS>& levels, uint8_t count);
+
+    static void updateTop(book& Book);
+};
+
+inline depthBook::depthBook(size_t Capacity) {
+    books.reserve(Capacity);
+    index.reserve(Capacity);
+    changes.reserve(2 * LEVELS);
+};
+
+inline void depthBook::update(const kc::tick& Tick) {
+    changes.clear();
+    apply(Tick);
+    if (onChanges && !changes.empty()) { onChanges(this, changes); };
+};
+
+inline void depthBook::update(const std::vector<kc::tick>& ticks) {
+    changes.clear();
+    for (const kc::tick& Tick : ticks) { apply(Tick); };
+    if (onChanges && !changes.empty()) { onChanges(this, changes); };
+};
+
+inline bool depthBook::getDepth(
+    int32_t instrumentToken, kc::tick::m_depth& depth) const {
+    auto it = index.find(instrumentToken);
+    if (it == index.end()) { return false; };
+    const book& Book = books[it->second];
+
+    depth = {};
+    const auto copy = [](const side& from,
+                          std::array<kc::depthWS, LEVELS>& to) {
+        for (size_t i = 0; i < from.count; i++) {
+            to[i] = { from.price[i], from.quantity[i], from.orders[i] };
+        };
+    };
+    copy(Book.buy, depth.buy);
+    copy(Book.sell, depth.sell);
+    depth.count = std::max(Book.buy.count, Book.sell.count);
+    return true;
+};
+
+inline bool depthBook::getTopOfBook(
+    int32_t instrumentToken, kc::topOfBook& top) const {
+    auto it = index.find(instrumentToken);
+    if (it == index.end()) { return false; };
+    top = books[it->second].top;
+    return true;
+};
+
+inline void depthBook::clear() {
+    books.clear();
+    index.clear();
+};
+
+inline void depthBook::apply(const kc::tick& Tick) {
+    if (Tick.marketDepth.count == 0) { return; };
+    auto [it, inserted] =
+        index.try_emplace(Tick.instrumentToken, books.size());
+    if (inserted) {
+        books.emplace_back().instrumentToken = Tick.instrumentToken;
+    };
+    book& Book = books[it->second];
+
+    const auto count = static_cast<uint8_t>(
+        std::min<size_t>(Tick.marketDepth.count, LEVELS));
+    Book.top.bidDepth += diff(Tick.instrumentToken, DEPTH_SIDE::BUY, Book.buy,
+        Tick.marketDepth.buy, count);
+    Book.top.askDepth += diff(Tick.instrumentToken, DEPTH_SIDE::SELL,
+        Book.sell, Tick.marketDepth.sell, count);
+    updateTop(Book);
+};
+
+inline int64_t depthBook::diff(int32_t instrumentToken, DEPTH_SIDE Side,
+    side& current, const std::array<kc::depthWS, LEVELS>& levels,
+    uint8_t count) {
+    side next;
+    for (uint8_t i = 0; i < count; i++) {
+        // empty levels are sent with a price & quantity of 0
+        if (levels[i].price == 0 && levels[i].quantity == 0) { continue; };
+        next.price[next.count] = levels[i].price;
+        next.quantity[next.count] = levels[i].quantity;
+        next.orders[next.count] = levels[i].orders;
+        next.count++;
+    };
+
+    int64_t quantityDelta = 0;
+    // bit j is set once level j of the current depth is matched
+    uint8_t matched = 0;
+    const auto isMatched = [&](uint8_t j) {
+        return ((matched >> j) & 1U) != 0;
+    };
+    for (uint8_t i = 0; i < next.count; i++) {
+        kc::depthChange change;
+        change.instrumentToken = instrumentToken;
+        change.side = Side;
+        change.level = i;
+        change.price = next.price[i];
+        change.quantity = next.quantity[i];
+        change.orders = next.orders[i];
+
+        uint8_t j = 0;
+        while (j < current.count &&
+               (isMatched(j) || current.price[j] != next.price[i])) {
+            j++;
+        };
+        if (j == current.count) {
+            change.change = DEPTH_CHANGE::ADDED;
+            change.quantityDelta = next.quantity[i];
+        } else {
+            matched |= static_cast<uint8_t>(1U << j);
+            if (current.quantity[j] == next.quantity[i] &&
+                current.orders[j] == next.orders[i]) {
+                continue;
+            };
+            change.change = DEPTH_CHANGE::MODIFIED;
+            change.quantityDelta = next.quantity[i] - current.quantity[j];
+        };
+        quantityDelta += change.quantityDelta;
+        changes.push_back(change);
+    };
+
+    for (uint8_t j = 0; j < current.count; j++) {
+        if (isMatched(j)) { continue; };
+        kc::depthChange change;
+        change.instrumentToken = instrumentToken;
+        change.side = Side;
+        change.change = DEPTH_CHANGE::REMOVED;
+        change.level = j;
+        change.price = current.price[j];
+        change.quantity = 0;
+        change.quantityDelta = -current.quantity[j];
+        quantityDelta += change.quantityDelta;
+        changes.push_back(change);
+    };
+
+    current = next;
+    return quantityDelta;
+};
+
+inline void depthBook::updateTop(book& Book) {
+    kc::topOfBook& top = Book.top;
+    const bool hasBid = Book.buy.count > 0;
+    const bool hasAsk = Book.sell.count > 0;
+    top.bidPrice = hasBid ? Book.buy.price[0] : -1;
+    top.bidQuantity = hasBid ? Book.buy.quantity[0] : 0;
+    top.askPrice = hasAsk ? Book.sell.price[0] : -1;
+    top.askQuantity = hasAsk ? Book.sell.quantity[0] : 0;
+
+    if (hasBid && hasAsk) {
+        top.spread = top.askPrice - top.bidPrice;
+        top.mid = (kc::toDouble(top.bidPrice, Book.instrumentToken) +
+                      kc::toDouble(top.askPrice, Book.instrumentToken)) /
+                  2;
+    } else {
+        top.spread = -1;
+        top.mid = -1;
+    };
+    const int64_t total =
+        static_cast<int64_t>(top.bidQuantity) + top.askQuantity;
+    top.imbalance = (total > 0) ? static_cast<double>(top.bidQuantity -
+                                                      top.askQuantity) /
+                                      static_cast<double>(total)
+                                : 0;
+};
+
+} // namespace kiteconnect
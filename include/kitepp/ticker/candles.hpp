@@ -0,0 +1,392 @@
+/*
+ *  Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+ *  SPDX-License-Identifier: MIT
+ *
+ *  Copyright (c) 2020-2022 Bhumit Attarde
+ *
+ *  Permission is hereby  granted, free of charge, to any  person obtaining a
+ * copy of this software and associated  documentation files (the "Software"),
+ * to deal in the Software  without restriction, including without  limitation
+ * the rights to  use, copy,  modify, merge,  publish, distribute,  sublicense,
+ * and/or  sell copies  of  the Software,  and  to  permit persons  to  whom the
+ * Software  is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS
+ * OR IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN
+ * NO EVENT  SHALL THE AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY
+ * CLAIM,  DAMAGES OR  OTHER LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT
+ * OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../price.hpp"
+#include "../responses/responses.hpp"
+#include "../utils.hpp"
+#include "timer.hpp"
+#include "ws.hpp"
+
+namespace kiteconnect {
+
+using std::string;
+namespace kc = kiteconnect;
+
+///
+/// \brief \a candleAggregator builds OHLCV candles of every instrument from
+///         ticks.
+///
+/// Trades are bucketed by their last trade time (or their exchange timestamp
+/// if they don't have one) and the volume of a candle is the increase in
+/// `volumeTraded` over it. Ticks with neither, e.g., LTP and quote mode ticks
+/// of tradable instruments, are dropped, so instruments should be in full
+/// mode. Candles are aligned to the start of the session in IST like
+/// historical data, e.g., hourly candles start at 09:15, 10:15 and so on.
+///
+/// Ticks that don't carry a new trade, i.e., quote updates whose volume
+/// hasn't changed, only advance the exchange time. A candle is closed as soon
+/// as the exchange time of a tick passes its end or, once started, by a timer
+/// when its interval and a grace delay for trades that are still in flight
+/// elapse on the local clock. The last `History` closed candles of every
+/// instrument are kept in preallocated ring buffers.
+///
+class candleAggregator {
+  public:
+    static constexpr size_t DEFAULT_CAPACITY = 3000;
+    static constexpr size_t DEFAULT_HISTORY = 60;
+    static constexpr unsigned int DEFAULT_GRACE = 2; // s
+    /// Start of the NSE and BSE sessions, 09:15 (s after midnight IST).
+    static constexpr unsigned int DEFAULT_SESSION_START = 33300;
+    /// Interval at which the timer checks for candles to close (ms).
+    static constexpr unsigned int TIMER_INTERVAL = 250;
+
+    /// @brief Called when a candle is closed.
+    std::function<void(candleAggregator* aggregator, int32_t instrumentToken,
+        const kc::historicalData& candle)>
+        onCandle;
+
+    ///
+    /// @brief Construct a new candle aggregator.
+    ///
+    /// @param Interval     interval of a candle (s), e.g., `60` for minute
+    ///                     candles
+    /// @param Capacity     number of instruments storage is reserved for
+    /// @param History      number of closed candles kept per instrument
+    /// @param Grace        time the timer waits after the end of a candle
+    ///                     before closing it (s)
+    /// @param SessionStart time candles are aligned to (s after midnight
+    ///                     IST), e.g., `32400` for the 09:00 MCX session
+    ///
+    /// @throw libException if \a Interval or \a History is `0`
+    ///
+    explicit candleAggregator(unsigned int Interval,
+        size_t Capacity = DEFAULT_CAPACITY, size_t History = DEFAULT_HISTORY,
+        unsigned int Grace = DEFAULT_GRACE,
+        unsigned int SessionStart = DEFAULT_SESSION_START);
+
+    ///
+    /// @brief Add a tick to the current candle of its instrument.
+    ///
+    /// @param Tick tick that should be added
+    ///
+    void update(const kc::tick& Tick);
+
+    ///
+    /// @brief Add ticks, e.g., the ones passed to `onTicks`.
+    ///
+    /// @param ticks ticks that should be added
+    ///
+    void update(const std::vector<kc::tick>& ticks);
+
+    ///
+    /// @brief Close candles with a timer on the event loop of \a Ticker.
+    ///
+    /// @param Ticker ticker whose loop the timer runs on, should be the one
+    ///               ticks are received from
+    ///
+    void start(kc::ticker& Ticker);
+
+    /// @brief Stop the timer started with `start()`.
+    void stop();
+
+    ///
+    /// @brief Close every candle whose interval and grace delay have elapsed.
+    ///
+    /// @param now current time (s, unix epoch)
+    ///
+    void close(int64_t now);
+
+    ///
+    /// @brief Get the closed candles of an instrument, oldest first.
+    ///
+    /// @param instrumentToken instrument token of the instrument
+    /// @param candles         set to the closed candles
+    ///
+    /// @return bool `false` if no tick has been received for the instrument
+    ///
+    bool getCandles(int32_t instrumentToken,
+        std::vector<kc::historicalData>& candles) const;
+
+    ///
+    /// @brief Get the candle of an instrument that hasn't been closed yet.
+    ///
+    /// @param instrumentToken instrument token of the instrument
+    /// @param candle          set to the open candle
+    ///
+    /// @return bool `false` if the instrument has no open candle
+    ///
+    bool getOpenCandle(
+        int32_t instrumentToken, kc::historicalData& candle) const;
+
+    ///
+    /// @brief Get the number of trades that arrived after their candle was
+    ///        closed. They're dropped, their volume isn't added to any
+    ///        candle.
+    ///
+    /// @return uint64_t number of late ticks
+    ///
+    [[nodiscard]] uint64_t getLateTickCount() const;
+
+  private:
+    struct bar {
+        int64_t start = -1; // s, unix epoch
+        double open = 0;
+        double high = 0;
+        double low = 0;
+        double close = 0;
+        int64_t volume = 0;
+        int64_t oi = -1;
+    };
+
+    struct series {
+        int32_t instrumentToken = -1;
+        bar current;
+        // ring of closed candles, `next` is the oldest once it's full
+        std::vector<bar> closed;
+        size_t next = 0;
+        size_t count = 0;
+        // end of the last closed candle
+        int64_t closedUntil = 0;
+        int32_t lastVolume = -1;
+    };
+
+    // IST, the timezone historical data is returned in
+    static constexpr int64_t UTC_OFFSET = 19800; // s
+
+    const int64_t interval;
+    const size_t history;
+    const int64_t grace;
+    const int64_t sessionStart;
+    std::vector<series> instruments;
+    std::unordered_map<int32_t, size_t> index;
+    uint64_t lateTicks = 0;
+    internal::loopTimer timer;
+
+    series& seriesOf(int32_t instrumentToken);
+
+    // start of the candle \a time falls in (s, unix epoch)
+    [[nodiscard]] int64_t bucketOf(int64_t time) const;
+
+    void closeBar(series& Series);
+
+    static kc::historicalData toHistoricalData(const bar& Bar);
+
+    static int64_t currentTime();
+};
+
+// NOLINTNEXTLINE(bugprone-easily-swappable-parameters)
+inline candleAggregator::candleAggregator(unsigned int Interval,
+    size_t Capacity, size_t History, unsigned int Grace,
+    unsigned int SessionStart)
+    : interval(Interval), history(History), grace(Grace),
+      sessionStart(SessionStart) {
+    if (Interval == 0 || History == 0) {
+        throw libException("candle interval and history must be positive");
+    };
+    instruments.reserve(Capacity);
+    index.reserve(Capacity);
+};
+
+inline void candleAggregator::update(const kc::tick& Tick) {
+    // the local clock would put lagging ticks in the wrong candle
+    if (Tick.lastTradeTime <= 0 && Tick.timestamp <= 0) { return; };
+    series& Series = seriesOf(Tick.instrumentToken);
+
+    // ticks without volume (e.g., LTP mode) are taken to be trades
+    bool traded = true;
+    int64_t volume = 0;
+    if (Tick.volumeTraded >= 0) {
+        // volume is cumulative for the day and starts over with it
+        if (Series.lastVolume >= 0 && Tick.volumeTraded >= Series.lastVolume) {
+            volume = Tick.volumeTraded - Series.lastVolume;
+            traded = volume > 0;
+        };
+        Series.lastVolume = Tick.volumeTraded;
+    };
+
+    // the last trade time of a quote update is the one of an earlier trade
+    int64_t time = traded ? Tick.lastTradeTime : 0;
+    if (time <= 0) { time = Tick.timestamp; };
+    if (time <= 0) { time = Tick.lastTradeTime; };
+    const int64_t start = bucketOf(time);
+
+    if (Series.current.start >= 0 && start > Series.current.start) {
+        closeBar(Series);
+    };
+    if (!traded) {
+        if (start == Series.current.start && Tick.oi >= 0) {
+            Series.current.oi = Tick.oi;
+        };
+        return;
+    };
+    if (start < Series.closedUntil ||
+        (Series.current.start >= 0 && start < Series.current.start)) {
+        lateTicks++;
+        return;
+    };
+
+    bar& Bar = Series.current;
+    if (Tick.oi >= 0) { Bar.oi = Tick.oi; };
+    if (Bar.start < 0) {
+        Bar.start = start;
+        Bar.open = kc::toDouble(Tick.lastPrice, Tick.instrumentToken);
+        Bar.high = Bar.open;
+        Bar.low = Bar.open;
+        Bar.close = Bar.open;
+        Bar.volume = volume;
+        return;
+    };
+    const double price = kc::toDouble(Tick.lastPrice, Tick.instrumentToken);
+    Bar.high = std::max(Bar.high, price);
+    Bar.low = std::min(Bar.low, price);
+    Bar.close = price;
+    Bar.volume += volume;
+};
+
+inline void candleAggregator::update(const std::vector<kc::tick>& ticks) {
+    for (const kc::tick& Tick : ticks) { update(Tick); };
+};
+
+inline void candleAggregator::start(kc::ticker& Ticker) {
+    timer.start(Ticker.hub->getLoop(), TIMER_INTERVAL, TIMER_INTERVAL,
+        [this]() { close(currentTime()); });
+};
+
+inline void candleAggregator::stop() { timer.stop(); };
+
+inline void candleAggregator::close(int64_t now) {
+    for (series& Series : instruments) {
+        if (Series.current.start >= 0 &&
+            Series.current.start + interval + grace <= now) {
+            closeBar(Series);
+        };
+    };
+};
+
+inline bool candleAggregator::getCandles(
+    int32_t instrumentToken, std::vector<kc::historicalData>& candles) const {
+    auto it = index.find(instrumentToken);
+    if (it == index.end()) { return false; };
+    const series& Series = instruments[it->second];
+
+    candles.clear();
+    candles.reserve(Series.count);
+    const size_t first = (Series.count < history) ? 0 : Series.next;
+    for (size_t i = 0; i < Series.count; i++) {
+        candles.emplace_back(
+            toHistoricalData(Series.closed[(first + i) % history]));
+    };
+    return true;
+};
+
+inline bool candleAggregator::getOpenCandle(
+    int32_t instrumentToken, kc::historicalData& candle) const {
+    auto it = index.find(instrumentToken);
+    if (it == index.end() || instruments[it->second].current.start < 0) {
+        return false;
+    };
+    candle = toHistoricalData(instruments[it->second].current);
+    return true;
+};
+
+inline uint64_t candleAggregator::getLateTickCount() const {
+    return lateTicks;
+};
+
+inline candleAggregator::series& candleAggregator::seriesOf(
+    int32_t instrumentToken) {
+    auto [it, inserted] =
+        index.try_emplace(instrumentToken, instruments.size());
+    if (inserted) {
+        series& Series = instruments.emplace_back();
+        Series.instrumentToken = instrumentToken;
+        Series.closed.resize(history);
+    };
+    return instruments[it->second];
+};
+
+inline int64_t candleAggregator::bucketOf(int64_t time) const {
+    const int64_t sinceSessionStart = time + UTC_OFFSET - sessionStart;
+    // non negative for times before the origin too
+    const int64_t offset =
+        ((sinceSessionStart % interval) + interval) % interval;
+    return time - offset;
+};
+
+inline void candleAggregator::closeBar(series& Series) {
+    const bar closed = Series.current;
+    Series.closed[Series.next] = closed;
+    Series.next = (Series.next + 1) % history;
+    Series.count = std::min(Series.count + 1, history);
+    Series.closedUntil = closed.start + interval;
+    Series.current = {};
+    if (onCandle) {
+        onCandle(this, Series.instrumentToken, toHistoricalData(closed));
+    };
+};
+
+inline kc::historicalData candleAggregator::toHistoricalData(const bar& Bar) {
+    kc::historicalData candle;
+    candle.open = Bar.open;
+    candle.high = Bar.high;
+    candle.low = Bar.low;
+    candle.close = Bar.close;
+    candle.volume = Bar.volume;
+    candle.OI = Bar.oi;
+
+    // same format as historical data, e.g., 2021-05-24T09:15:00+0530
+    const auto local = static_cast<std::time_t>(Bar.start + UTC_OFFSET);
+    std::tm time {};
+#if defined(_WIN32)
+    gmtime_s(&time, &local);
+#else
+    gmtime_r(&local, &time);
+#endif
+    candle.datetime =
+        FMT("{0:04d}-{1:02d}-{2:02d}T{3:02d}:{4:02d}:{5:02d}+0530",
+            time.tm_year + 1900, time.tm_mon + 1, time.tm_mday, time.tm_hour,
+            time.tm_min, time.tm_sec);
+    return candle;
+};
+
+inline int64_t candleAggregator::currentTime() {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch())
+        .count();
+};
+
+} // namespace kiteconnect
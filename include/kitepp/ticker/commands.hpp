@@ -0,0 +1,163 @@
+/*
+ *  Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+ *  SPDX-License-Identifier: MIT
+ *
+ *  Copyright (c) 2020-2022 Bhumit Attarde
+ *
+ *  Permission is hereby  granted, free of charge, to any  person obtaining a
+ * copy of this software and associated  documentation files (the "Software"),
+ * to deal in the Software  without restriction, including without  limitation
+ * the rights to  use, copy,  modify, merge,  publish, distribute,  sublicense,
+ * and/or  sell copies  of  the Software,  and  to  permit persons  to  whom the
+ * Software  is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS
+ * OR IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN
+ * NO EVENT  SHALL THE AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY
+ * CLAIM,  DAMAGES OR  OTHER LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT
+ * OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <utility>
+
+#include <uWS/uWS.h>
+
+namespace kiteconnect::internal {
+
+///
+/// @brief Queue of commands that any thread can push and that are run on a
+///        uWS event loop.
+///
+/// Pushing is lock-free: a command is linked in with a single atomic exchange
+/// (Vyukov's MPSC queue) and the loop is woken with an async handle, so
+/// pushing threads never wait for the loop. Commands are run in the order
+/// they were pushed. Commands that are queued when the queue is closed or
+/// destroyed are destroyed without being run, and pushing to a closed queue
+/// fails until it's started again.
+///
+class commandQueue {
+  public:
+    using command = std::function<void()>;
+
+    commandQueue() : head(&stub), tail(&stub) {};
+    commandQueue(const commandQueue&) = delete;
+    commandQueue& operator=(const commandQueue&) = delete;
+    commandQueue(commandQueue&&) = delete;
+    commandQueue& operator=(commandQueue&&) = delete;
+    ~commandQueue() {
+        close();
+        // NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
+        if (tail != &stub) { delete tail; };
+    };
+
+    ///
+    /// @brief Start running commands on \a loop. Has to be called on the
+    ///        loop's thread, or before the loop is run. Commands pushed before
+    ///        are run on the next iteration.
+    ///
+    void start(uS::Loop* loop) {
+        closed.store(false, std::memory_order_seq_cst);
+        if (async != nullptr) { return; };
+        // NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
+        auto* Async = new uS::Async(loop);
+        Async->setData(this);
+        Async->start(wake);
+        async.store(Async, std::memory_order_release);
+        Async->send();
+    };
+
+    /// @brief Stop running commands, has to be called on the loop's thread.
+    void close() {
+        closed.store(true, std::memory_order_seq_cst);
+        uS::Async* Async = async.exchange(nullptr, std::memory_order_seq_cst);
+        // producers that saw the queue open are done linking their commands
+        // and waking the handle once this is 0, later ones see it closed
+        while (pushing.load(std::memory_order_seq_cst) != 0) {
+            std::this_thread::yield();
+        };
+        // frees the handle once the loop is done with it
+        if (Async != nullptr) { Async->close(); };
+        command dropped;
+        while (pop(dropped)) {};
+    };
+
+    [[nodiscard]] bool isActive() const {
+        return async.load(std::memory_order_acquire) != nullptr;
+    };
+
+    ///
+    /// @brief Queue \a Command and wake the loop. Can be called from any
+    ///        thread.
+    ///
+    /// @return bool `false` if the queue is closed, \a Command isn't queued
+    ///
+    bool push(command Command) {
+        // NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
+        auto* Node = new node { {}, std::move(Command) };
+        // keeps close() from closing the handle until it has been woken
+        pushing.fetch_add(1, std::memory_order_seq_cst);
+        if (closed.load(std::memory_order_seq_cst)) {
+            pushing.fetch_sub(1, std::memory_order_seq_cst);
+            // NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
+            delete Node;
+            return false;
+        };
+        node* previous = head.exchange(Node, std::memory_order_acq_rel);
+        // consumers see the node once it's linked
+        previous->next.store(Node, std::memory_order_release);
+        uS::Async* Async = async.load(std::memory_order_seq_cst);
+        if (Async != nullptr) { Async->send(); };
+        pushing.fetch_sub(1, std::memory_order_seq_cst);
+        return true;
+    };
+
+    /// @brief Run every queued command, on the loop's thread.
+    void run() {
+        command Command;
+        while (pop(Command)) { Command(); };
+    };
+
+  private:
+    struct node {
+        std::atomic<node*> next { nullptr };
+        command value;
+    };
+    // producers append at the head, the consumer pops at the tail, which is
+    // always a node whose command has already been taken
+    node stub;
+    std::atomic<node*> head;
+    node* tail;
+    std::atomic<uS::Async*> async { nullptr };
+    std::atomic<bool> closed { false };
+    // number of producers between checking `closed` and waking the handle
+    std::atomic<unsigned int> pushing { 0 };
+
+    // a pushed node that isn't linked yet is seen as an empty queue, it's
+    // picked up on the wake-up that follows it
+    bool pop(command& Command) {
+        node* next = tail->next.load(std::memory_order_acquire);
+        if (next == nullptr) { return false; };
+        Command = std::move(next->value);
+        next->value = nullptr;
+        // NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
+        if (tail != &stub) { delete tail; };
+        tail = next;
+        return true;
+    };
+
+    static void wake(uS::Async* Async) {
+        static_cast<commandQueue*>(Async->getData())->run();
+    };
+};
+
+} // namespace kiteconnect::internal
@@ -0,0 +1,245 @@
+/*
+ *  Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+ *  SPDX-License-Identifier: MIT
+ *
+ *  Copyright (c) 2020-2022 Bhumit Attarde
+ *
+ *  Permission is hereby  granted, free of charge, to any  person obtaining a
+ * copy of this software and associated  documentation files (the "Software"),
+ * to deal in the Software  without restriction, including without  limitation
+ * the rights to  use, copy,  modify, merge,  publish, distribute,  sublicense,
+ * and/or  sell copies  of  the Software,  and  to  permit persons  to  whom the
+ * Software  is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS
+ * OR IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN
+ * NO EVENT  SHALL THE AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY
+ * CLAIM,  DAMAGES OR  OTHER LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT
+ * OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "../price.hpp"
+#include "../responses/ws.hpp"
+#include "../utils.hpp"
+
+// SIMD kernels are only built for x86 with GCC/clang since they rely on
+// function level target attributes and __builtin_cpu_supports()
+#if !defined(KITE_DISABLE_SIMD) &&                                             \
+    (defined(__x86_64__) || defined(__i386__)) &&                              \
+    (defined(__GNUC__) || defined(__clang__))
+#define KITE_DEPTH_SIMD 1
+#include <immintrin.h>
+#endif
+
+namespace kiteconnect::internal::depth {
+
+namespace kc = kiteconnect;
+namespace utils = kc::internal::utils;
+
+/// Number of market depth entries in a full mode packet (5 buy + 5 sell).
+constexpr size_t LEVELS = 10;
+/// Size of a single depth entry: int32 quantity, int32 price, int16 orders and
+/// 2 bytes of padding.
+constexpr size_t ENTRY_SIZE = 12;
+
+using levels = std::array<kc::depthWS, LEVELS>;
+using decoder = void (*)(const char* bytes, double divisor, levels& out);
+
+///
+/// @brief Decode the depth block of a full mode packet one field at a time.
+///
+/// @param bytes   start of the depth block (byte 64 of a full packet)
+/// @param divisor segment divisor prices are divided by, unless prices are
+///                fixed point
+/// @param out     decoded entries, buy entries followed by sell entries
+///
+inline void decodeScalar(const char* bytes, double divisor, levels& out) {
+    // NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,
+    // cppcoreguidelines-pro-bounds-constant-array-index)
+    for (size_t i = 0; i < LEVELS; i++) {
+        const char* entry = bytes + (i * ENTRY_SIZE);
+        out[i].quantity = utils::bytes::readBigEndian<int32_t>(entry);
+        out[i].price = internal::fromScaled(
+            utils::bytes::readBigEndian<int32_t>(entry + 4), divisor);
+        out[i].orders = utils::bytes::readBigEndian<int16_t>(entry + 8);
+    };
+    // NOLINTEND(cppcoreguidelines-avoid-magic-numbers,
+    // cppcoreguidelines-pro-bounds-constant-array-index)
+}
+
+#ifdef KITE_DEPTH_SIMD
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers,
+// cppcoreguidelines-pro-bounds-constant-array-index,
+// cppcoreguidelines-pro-type-reinterpret-cast, hicpp-signed-bitwise)
+
+// Every entry is loaded as a 16 byte vector whose 32 bit lanes, once byte
+// swapped, hold {quantity, price, orders << 16 | padding, next quantity}. Four
+// such vectors are transposed into a vector of quantities, prices & orders.
+
+__attribute__((target("sse4.1"))) inline __m128i loadEntrySSE(
+    const char* entry) {
+    const __m128i swap32 =
+        _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    return _mm_shuffle_epi8(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(entry)), swap32);
+}
+
+// the last entry is loaded from 4 bytes earlier so that we don't read past the
+// end of the packet
+__attribute__((target("sse4.1"))) inline __m128i loadLastEntrySSE(
+    const char* entry) {
+    const __m128i swap32 =
+        _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    return _mm_shuffle_epi8(
+        _mm_srli_si128(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(entry - 4)), 4),
+        swap32);
+}
+
+__attribute__((target("sse4.1"))) inline void storeGroupSSE(__m128i v0,
+    __m128i v1, __m128i v2, __m128i v3, __m128d div, kc::depthWS* out,
+    size_t count) {
+    const __m128i t0 = _mm_unpacklo_epi32(v0, v1);
+    const __m128i t1 = _mm_unpacklo_epi32(v2, v3);
+    const __m128i t2 = _mm_unpackhi_epi32(v0, v1);
+    const __m128i t3 = _mm_unpackhi_epi32(v2, v3);
+    const __m128i price = _mm_unpackhi_epi64(t0, t1);
+
+    alignas(16) std::array<int32_t, 4> quantities {};
+    alignas(16) std::array<int32_t, 4> orders {};
+    _mm_store_si128(reinterpret_cast<__m128i*>(quantities.data()),
+        _mm_unpacklo_epi64(t0, t1));
+    _mm_store_si128(reinterpret_cast<__m128i*>(orders.data()),
+        _mm_srai_epi32(_mm_unpacklo_epi64(t2, t3), 16));
+#ifdef KITE_FIXED_POINT_PRICES
+    // prices are kept as they're sent, so there's nothing to divide
+    static_cast<void>(div);
+    alignas(16) std::array<int32_t, 4> prices {};
+    _mm_store_si128(reinterpret_cast<__m128i*>(prices.data()), price);
+#else
+    alignas(16) std::array<double, 4> prices {};
+    _mm_store_pd(prices.data(), _mm_div_pd(_mm_cvtepi32_pd(price), div));
+    _mm_store_pd(prices.data() + 2,
+        _mm_div_pd(_mm_cvtepi32_pd(_mm_unpackhi_epi64(price, price)), div));
+#endif
+
+    for (size_t i = 0; i < count; i++) {
+        out[i].quantity = quantities[i];
+        out[i].price = prices[i];
+        out[i].orders = static_cast<int16_t>(orders[i]);
+    };
+}
+
+/// @brief Decode the depth block four entries at a time using SSE4.1.
+__attribute__((target("sse4.1"))) inline void decodeSSE41(
+    const char* bytes, double divisor, levels& out) {
+    const __m128d div = _mm_set1_pd(divisor);
+    for (size_t i = 0; i < 8; i += 4) {
+        const char* entry = bytes + (i * ENTRY_SIZE);
+        storeGroupSSE(loadEntrySSE(entry), loadEntrySSE(entry + ENTRY_SIZE),
+            loadEntrySSE(entry + (2 * ENTRY_SIZE)),
+            loadEntrySSE(entry + (3 * ENTRY_SIZE)), div, &out[i], 4);
+    };
+    const __m128i zero = _mm_setzero_si128();
+    storeGroupSSE(loadEntrySSE(bytes + (8 * ENTRY_SIZE)),
+        loadLastEntrySSE(bytes + (9 * ENTRY_SIZE)), zero, zero, div, &out[8],
+        2);
+}
+
+// entry i goes to the low lane and entry i + 4 to the high lane so that the
+// in-lane transpose yields entries 0-3 followed by entries 4-7
+__attribute__((target("avx2"))) inline __m256i loadEntryPairAVX2(
+    const char* entry) {
+    const __m256i swap32 = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9,
+        8, 15, 14, 13, 12, 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13,
+        12);
+    const __m128i low =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(entry));
+    const __m128i high = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(entry + (4 * ENTRY_SIZE)));
+    return _mm256_shuffle_epi8(
+        _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1), swap32);
+}
+
+/// @brief Decode the depth block eight entries at a time using AVX2.
+__attribute__((target("avx2"))) inline void decodeAVX2(
+    const char* bytes, double divisor, levels& out) {
+    const __m256i v0 = loadEntryPairAVX2(bytes);
+    const __m256i v1 = loadEntryPairAVX2(bytes + ENTRY_SIZE);
+    const __m256i v2 = loadEntryPairAVX2(bytes + (2 * ENTRY_SIZE));
+    const __m256i v3 = loadEntryPairAVX2(bytes + (3 * ENTRY_SIZE));
+    const __m256i t0 = _mm256_unpacklo_epi32(v0, v1);
+    const __m256i t1 = _mm256_unpacklo_epi32(v2, v3);
+    const __m256i t2 = _mm256_unpackhi_epi32(v0, v1);
+    const __m256i t3 = _mm256_unpackhi_epi32(v2, v3);
+    const __m256i price = _mm256_unpackhi_epi64(t0, t1);
+
+    alignas(32) std::array<int32_t, 8> quantities {};
+    alignas(32) std::array<int32_t, 8> orders {};
+    _mm256_store_si256(reinterpret_cast<__m256i*>(quantities.data()),
+        _mm256_unpacklo_epi64(t0, t1));
+    _mm256_store_si256(reinterpret_cast<__m256i*>(orders.data()),
+        _mm256_srai_epi32(_mm256_unpacklo_epi64(t2, t3), 16));
+#ifdef KITE_FIXED_POINT_PRICES
+    alignas(32) std::array<int32_t, 8> prices {};
+    _mm256_store_si256(reinterpret_cast<__m256i*>(prices.data()), price);
+#else
+    const __m256d div = _mm256_set1_pd(divisor);
+    alignas(32) std::array<double, 8> prices {};
+    _mm256_store_pd(prices.data(),
+        _mm256_div_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(price)), div));
+    _mm256_store_pd(prices.data() + 4,
+        _mm256_div_pd(
+            _mm256_cvtepi32_pd(_mm256_extracti128_si256(price, 1)), div));
+#endif
+
+    for (size_t i = 0; i < 8; i++) {
+        out[i].quantity = quantities[i];
+        out[i].price = prices[i];
+        out[i].orders = static_cast<int16_t>(orders[i]);
+    };
+
+    const __m128i zero = _mm_setzero_si128();
+    storeGroupSSE(loadEntrySSE(bytes + (8 * ENTRY_SIZE)),
+        loadLastEntrySSE(bytes + (9 * ENTRY_SIZE)), zero, zero,
+        _mm_set1_pd(divisor), &out[8], 2);
+}
+
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers,
+// cppcoreguidelines-pro-bounds-constant-array-index,
+// cppcoreguidelines-pro-type-reinterpret-cast, hicpp-signed-bitwise)
+#endif
+
+///
+/// @brief Pick the fastest depth decoder supported by the running CPU.
+///
+inline decoder selectDecoder() {
+#ifdef KITE_DEPTH_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) { return decodeAVX2; };
+    if (__builtin_cpu_supports("sse4.1")) { return decodeSSE41; };
+#endif
+    return decodeScalar;
+}
+
+///
+/// @brief Decode the depth block of a full mode packet using the decoder
+///        selected for the running CPU.
+///
+inline void decode(const char* bytes, double divisor, levels& out) {
+    static const decoder selected = selectDecoder();
+    selected(bytes, divisor, out);
+}
+
+} // namespace kiteconnect::internal::depth
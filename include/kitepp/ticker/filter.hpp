@@ -0,0 +1,124 @@
+/*
+ *  Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+ *  SPDX-License-Identifier: MIT
+ *
+ *  Copyright (c) 2020-2022 Bhumit Attarde
+ *
+ *  Permission is hereby  granted, free of charge, to any  person obtaining a
+ * copy of this software and associated  documentation files (the "Software"),
+ * to deal in the Software  without restriction, including without  limitation
+ * the rights to  use, copy,  modify, merge,  publish, distribute,  sublicense,
+ * and/or  sell copies  of  the Software,  and  to  permit persons  to  whom the
+ * Software  is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS
+ * OR IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN
+ * NO EVENT  SHALL THE AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY
+ * CLAIM,  DAMAGES OR  OTHER LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT
+ * OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "depth.hpp"
+#include "packet.hpp"
+
+namespace kiteconnect {
+
+namespace kc = kiteconnect;
+
+/// Fields compared to decide whether a tick has changed.
+enum class TICK_FILTER : uint8_t
+{
+    /// every tick is delivered
+    NONE,
+    /// last price
+    LTP,
+    /// last price, traded & pending quantities and best bid & offer
+    TOP_OF_BOOK,
+    /// every field except timestamps
+    FULL_DEPTH
+};
+
+namespace internal::filter {
+
+namespace pkt = kc::internal::packet;
+
+///
+/// @brief Hash of the fields of a packet \a filter compares.
+///
+/// Fields are hashed straight from the packet's bytes, so unchanged packets
+/// can be dropped without decoding them.
+///
+/// @param packet start of the packet
+/// @param size   size of the packet, at least `LTP_SIZE`. Also part of the
+///               hash so that a mode change is never suppressed.
+/// @param filter fields that should be hashed
+///
+inline uint64_t fingerprint(
+    const char* packet, size_t size, TICK_FILTER filter) {
+    // NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+    // FNV-1a over 4 byte words, every field is 4 byte aligned
+    constexpr uint64_t OFFSET_BASIS = 14695981039346656037ULL;
+    constexpr uint64_t PRIME = 1099511628211ULL;
+    uint64_t hash = OFFSET_BASIS ^ size;
+    const auto mix = [&](size_t from, size_t to) {
+        for (size_t offset = from; offset + 4 <= to; offset += 4) {
+            uint32_t word = 0;
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            std::memcpy(&word, packet + offset, sizeof(word));
+            hash = (hash ^ word) * PRIME;
+        };
+    };
+
+    const bool isIndex =
+        size == pkt::INDICES_QUOTE_SIZE || size == pkt::INDICES_FULL_SIZE;
+    const bool isQuote = size == pkt::QUOTE_SIZE || size == pkt::FULL_SIZE;
+    constexpr size_t SELL =
+        pkt::DEPTH + (kc::tick::DEPTH_LEVELS * internal::depth::ENTRY_SIZE);
+    switch (filter) {
+        case TICK_FILTER::NONE: break;
+        case TICK_FILTER::LTP: mix(pkt::LAST_PRICE, pkt::LTP_SIZE); break;
+        case TICK_FILTER::TOP_OF_BOOK:
+            if (isIndex) {
+                mix(pkt::LAST_PRICE, pkt::INDICES_TIMESTAMP);
+            } else if (isQuote) {
+                mix(pkt::LAST_PRICE, pkt::OPEN);
+            } else {
+                mix(pkt::LAST_PRICE, pkt::LTP_SIZE);
+            };
+            if (size == pkt::FULL_SIZE) {
+                mix(pkt::DEPTH, pkt::DEPTH + internal::depth::ENTRY_SIZE);
+                mix(SELL, SELL + internal::depth::ENTRY_SIZE);
+            };
+            break;
+        case TICK_FILTER::FULL_DEPTH:
+            if (isIndex) {
+                mix(pkt::LAST_PRICE, pkt::INDICES_TIMESTAMP);
+            } else if (isQuote) {
+                mix(pkt::LAST_PRICE, pkt::LAST_TRADE_TIME);
+            } else {
+                mix(pkt::LAST_PRICE, size);
+            };
+            if (size == pkt::FULL_SIZE) {
+                mix(pkt::OI, pkt::TIMESTAMP);
+                mix(pkt::DEPTH, pkt::FULL_SIZE);
+            };
+            break;
+    };
+    return hash;
+    // NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
+}
+
+} // namespace internal::filter
+
+} // namespace kiteconnect
@@ -25,17 +25,22 @@
 
 #pragma once
 
-#include <algorithm> //reverse
+#include <algorithm>
+#include <array>
 #include <atomic>
+#include <charconv>
 #include <chrono>
 #include <cstdint>
-#include <cstring> //memcpy
+#include <cstring>
+#include <exception>
 #include <functional>
+#include <future>
 #include <ios>
 #include <iostream>
 #include <limits>
+#include <memory>
 #include <string>
-#include <thread>
+#include <system_error>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -44,6 +49,7 @@
 #include "../responses/responses.hpp"
 #include "../userconstants.hpp" //modes
 #include "../utils.hpp"
+#include "packet.hpp"
 #include "ws.hpp"
 
 #include "rapidjson/include/rapidjson/document.h"
@@ -64,11 +70,20 @@ namespace utils = kc::internal::utils;
 inline ticker::ticker(string Key, unsigned int ConnectTimeout,
     bool EnableReconnect, unsigned int maxreconnectdelay,
     unsigned int MaxReconnectTries)
+    : ticker(std::move(Key), nullptr, ConnectTimeout, EnableReconnect,
+          maxreconnectdelay, MaxReconnectTries) {};
+
+// NOLINTNEXTLINE(bugprone-easily-swappable-parameters)
+inline ticker::ticker(string Key, uWS::Hub* Hub, unsigned int ConnectTimeout,
+    bool EnableReconnect, unsigned int MaxReconnectDelay,
+    unsigned int MaxReconnectTries)
     : key(std::move(Key)),
+      ownedHub((Hub == nullptr) ? std::make_unique<uWS::Hub>() : nullptr),
+      hub((Hub == nullptr) ? ownedHub.get() : Hub),
+      group(hub->createGroup<uWS::CLIENT>()),
       connectTimeout(ConnectTimeout * utils::MILLISECONDS_IN_A_SECOND),
-      enableReconnect(EnableReconnect), maxReconnectDelay(maxreconnectdelay),
-      maxReconnectTries(MaxReconnectTries),
-      group(hub.createGroup<uWS::CLIENT>()) {};
+      enableReconnect(EnableReconnect), maxReconnectDelay(MaxReconnectDelay),
+      maxReconnectTries(MaxReconnectTries) {};
 
 inline void ticker::setApiKey(const string& Key) { key = Key; };
 
@@ -79,7 +94,85 @@ inline void ticker::setAccessToken(const string& Token) { token = Token; };
 inline string ticker::getAccessToken() const { return token; };
 
 inline void ticker::connect() {
-    assignCallbacks();
+    assignCallbacks(functionCallbacks { this });
+    commands.start(hub->getLoop());
+    connectInternal();
+};
+
+template <class Listener>
+inline void ticker::connect(Listener& listener) {
+    using handlers = internal::listenerHandlers<Listener>;
+    // paths that aren't per frame, e.g., conflation & replays, call the
+    // std::function callbacks
+    if constexpr (handlers::ON_CONNECT) {
+        onConnect = [&listener](ticker* Ticker) {
+            listener.onConnect(Ticker);
+        };
+    };
+    if constexpr (handlers::ON_TICKS) {
+        onTicks = [&listener](
+                      ticker* Ticker, const std::vector<kc::tick>& ticks) {
+            listener.onTicks(Ticker, ticks);
+        };
+    };
+    if constexpr (handlers::ON_TICK_VIEWS) {
+        onTickViews = [&listener](ticker* Ticker,
+                          const std::vector<kc::tickView>& ticks) {
+            listener.onTickViews(Ticker, ticks);
+        };
+    };
+    if constexpr (handlers::ON_TICK_BATCH) {
+        onTickBatch = [&listener](ticker* Ticker, const kc::tickBatch& batch) {
+            listener.onTickBatch(Ticker, batch);
+        };
+    };
+    if constexpr (handlers::ON_ORDER_UPDATE) {
+        onOrderUpdate = [&listener](
+                            ticker* Ticker, const kc::postback& postback) {
+            listener.onOrderUpdate(Ticker, postback);
+        };
+    };
+    if constexpr (handlers::ON_ORDER_UPDATE_VIEW) {
+        onOrderUpdateView = [&listener](ticker* Ticker,
+                                const kc::postbackView& postback) {
+            listener.onOrderUpdateView(Ticker, postback);
+        };
+    };
+    if constexpr (handlers::ON_MESSAGE) {
+        onMessage = [&listener](ticker* Ticker, const string& message) {
+            listener.onMessage(Ticker, message);
+        };
+    };
+    if constexpr (handlers::ON_ERROR) {
+        onError = [&listener](
+                      ticker* Ticker, int code, const string& message) {
+            listener.onError(Ticker, code, message);
+        };
+    };
+    if constexpr (handlers::ON_CONNECT_ERROR) {
+        onConnectError = [&listener](ticker* Ticker) {
+            listener.onConnectError(Ticker);
+        };
+    };
+    if constexpr (handlers::ON_TRY_RECONNECT) {
+        onTryReconnect = [&listener](
+                             ticker* Ticker, unsigned int attemptCount) {
+            listener.onTryReconnect(Ticker, attemptCount);
+        };
+    };
+    if constexpr (handlers::ON_RECONNECT_FAIL) {
+        onReconnectFail = [&listener](ticker* Ticker) {
+            listener.onReconnectFail(Ticker);
+        };
+    };
+    if constexpr (handlers::ON_CLOSE) {
+        onClose = [&listener](
+                      ticker* Ticker, int code, const string& message) {
+            listener.onClose(Ticker, code, message);
+        };
+    };
+    assignCallbacks(listenerCallbacks<Listener> { this, &listener });
+    commands.start(hub->getLoop());
     connectInternal();
 };
 
@@ -87,296 +180,845 @@ inline bool ticker::isConnected() const { return ws != nullptr; };
 
 inline std::chrono::time_point<std::chrono::system_clock> ticker::
     getLastBeatTime() const {
-    return lastBeatTime;
+    if (lastBeatTime == 0) { return {}; };
+    // the beat time is monotonic, it's as long ago on the system clock
+    const std::chrono::nanoseconds ago(kc::tickerStats::now() - lastBeatTime);
+    return std::chrono::system_clock::now() -
+           std::chrono::duration_cast<std::chrono::system_clock::duration>(ago);
+};
+
+inline void ticker::setTickBuffer(std::vector<kc::tick>* buffer) {
+    userTickBuffer = buffer;
+};
+
+inline void ticker::enableSnapshots(size_t capacity) {
+    snapshots = std::make_unique<kc::tickSnapshots>(capacity);
+};
+
+inline bool ticker::getLatestTick(
+    int32_t instrumentToken, kc::tick& Tick) const {
+    return snapshots && snapshots->load(instrumentToken, Tick);
 };
 
-inline void ticker::run() { hub.run(); };
+inline void ticker::addTickQueue(kc::tickQueue* queue) {
+    tickQueues.push_back(queue);
+};
+
+inline void ticker::removeTickQueue(kc::tickQueue* queue) {
+    tickQueues.erase(std::remove(tickQueues.begin(), tickQueues.end(), queue),
+        tickQueues.end());
+};
+
+inline void ticker::enableConflation(unsigned int interval) {
+    // a timer without an interval would fire once and never again
+    if (interval == 0) {
+        throw kc::libException("conflation interval must be positive");
+    };
+    conflationTimer.start(
+        hub->getLoop(), interval, interval, [this]() { flushConflated(); });
+};
+
+inline void ticker::disableConflation() {
+    conflationTimer.stop();
+    flushConflated();
+};
+
+inline uint64_t ticker::getMergedTickCount() const {
+    return mergedTicks.load(std::memory_order_relaxed);
+};
+
+inline void ticker::setTickFilter(kc::TICK_FILTER filter) {
+    tickFilter = filter;
+    tickFingerprints.clear();
+};
+
+inline uint64_t ticker::getSuppressedTickCount() const {
+    return suppressedTicks.load(std::memory_order_relaxed);
+};
+
+#ifndef KITE_DISABLE_JOURNAL
+inline void ticker::enableJournal(
+    const string& pathPrefix, size_t segmentSize) {
+    journal.reset();
+    journal = std::make_unique<kc::tickJournal>(pathPrefix, segmentSize);
+};
+
+inline void ticker::disableJournal() { journal.reset(); };
+
+inline const kc::tickJournal* ticker::getJournal() const {
+    return journal.get();
+};
+#endif
+
+inline const kc::tickerStats& ticker::getStats() const {
+#ifndef KITE_DISABLE_TICKER_STATS
+    return stats;
+#else
+    static const kc::tickerStats disabled;
+    return disabled;
+#endif
+};
+
+inline void ticker::resetStats() {
+#ifndef KITE_DISABLE_TICKER_STATS
+    stats.reset();
+#endif
+};
+
+inline void ticker::enableWatchdog(
+    unsigned int PongTimeout, unsigned int FrameTimeout) {
+    constexpr uint64_t nsInMs = 1000000;
+    pongTimeout = PongTimeout * nsInMs;
+    frameTimeout = FrameTimeout * nsInMs;
+    pingSentTime = 0;
+    watchdogTimer.start(
+        hub->getLoop(), WATCHDOG_INTERVAL, WATCHDOG_INTERVAL, [this]() {
+            watch();
+        });
+};
+
+inline void ticker::disableWatchdog() { watchdogTimer.stop(); };
+
+inline const kc::latencyHistogram& ticker::getPingRtt() const {
+    return pingRtt;
+};
+
+inline uint64_t ticker::getWatchdogTimeoutCount() const {
+    return watchdogTimeouts.load(std::memory_order_relaxed);
+};
+
+inline void ticker::run() { hub->run(); };
 
 inline void ticker::stop() {
+    releaseLoop();
+    isReconnecting = false;
     if (isConnected()) { ws->close(); };
 };
 
+inline void ticker::releaseLoop() {
+    // pending calls from other threads fail with a broken promise, later ones
+    // with a libException
+    commands.close();
+    conflationTimer.stop();
+    requestTimer.stop();
+    pendingTokens.clear();
+    pendingRequests.clear();
+    reconnectTimer.stop();
+    watchdogTimer.stop();
+};
+
 inline void ticker::subscribe(const std::vector<int>& instrumentTokens) {
-    utils::json::json<utils::json::JsonObject> req;
-    req.field("a", "subscribe");
-    req.field("v", instrumentTokens);
-    string reqStr = req.serialize();
-
-    if (isConnected()) {
-        ws->send(reqStr.data(), reqStr.size(), uWS::OpCode::TEXT);
-        for (const int tok : instrumentTokens) {
-            subbedInstruments[tok] = DEFAULT_MODE;
-        };
-    } else {
+    if (!isConnected()) {
         throw kc::libException("not connected to websocket server");
     };
+    queueRequest(REQUEST::SUBSCRIBE, instrumentTokens);
+    for (const int tok : instrumentTokens) {
+        subbedInstruments[tok] = DEFAULT_MODE;
+    };
 };
 
 inline void ticker::unsubscribe(const std::vector<int>& instrumentTokens) {
-    utils::json::json<utils::json::JsonObject> req;
-    req.field("a", "unsubscribe");
-    req.field("v", instrumentTokens);
-    string reqStr = req.serialize();
-
-    if (isConnected()) {
-        ws->send(reqStr.data(), reqStr.size(), uWS::OpCode::TEXT);
-        for (const int tok : instrumentTokens) {
-            auto it = subbedInstruments.find(tok);
-            if (it != subbedInstruments.end()) { subbedInstruments.erase(it); };
-        };
-    } else {
+    if (!isConnected()) {
         throw kc::libException("not connected to websocket server");
     };
+    queueRequest(REQUEST::UNSUBSCRIBE, instrumentTokens);
+    for (const int tok : instrumentTokens) {
+        auto it = subbedInstruments.find(tok);
+        if (it != subbedInstruments.end()) { subbedInstruments.erase(it); };
+    };
 };
 
 inline void ticker::setMode(
     const string& mode, const std::vector<int>& instrumentTokens) {
-    // create request json
-    rj::Document req;
-    req.SetObject();
-    auto& reqAlloc = req.GetAllocator();
-    rj::Value val;
-    rj::Value valArr(rj::kArrayType);
-    rj::Value toksArr(rj::kArrayType);
-
-    val.SetString("mode", reqAlloc);
-    req.AddMember("a", val, reqAlloc);
-
-    val.SetString(mode.c_str(), mode.size(), reqAlloc);
-    valArr.PushBack(val, reqAlloc);
-    for (const int tok : instrumentTokens) { toksArr.PushBack(tok, reqAlloc); }
-    valArr.PushBack(toksArr, reqAlloc);
-    req.AddMember("v", valArr, reqAlloc);
-
-    // send the request
-    string reqStr = utils::json::serialize(req);
-    if (isConnected()) {
-        ws->send(reqStr.data(), reqStr.size(), uWS::OpCode::TEXT);
-        for (const int tok : instrumentTokens) {
-            if (mode == MODE_LTP) {
-                subbedInstruments[tok] = MODES::LTP;
-            } else if (mode == MODE_QUOTE) {
-                subbedInstruments[tok] = MODES::QUOTE;
-            } else {
-                subbedInstruments[tok] = MODES::FULL;
-            }
-        };
-    } else {
+    if (!isConnected()) {
         throw kc::libException("not connected to websocket server");
     };
+    const MODES parsed = parseMode(mode);
+    queueRequest(REQUEST::MODE, instrumentTokens, parsed);
+    for (const int tok : instrumentTokens) { subbedInstruments[tok] = parsed; };
+};
+
+inline std::future<void> ticker::subscribeAsync(
+    std::vector<int> instrumentTokens) {
+    return runOnLoop([this, tokens = std::move(instrumentTokens)]() {
+        subscribe(tokens);
+    });
+};
+
+inline std::future<void> ticker::unsubscribeAsync(
+    std::vector<int> instrumentTokens) {
+    return runOnLoop([this, tokens = std::move(instrumentTokens)]() {
+        unsubscribe(tokens);
+    });
+};
+
+inline std::future<void> ticker::setModeAsync(
+    string mode, std::vector<int> instrumentTokens) {
+    return runOnLoop([this, Mode = std::move(mode),
+                         tokens = std::move(instrumentTokens)]() {
+        setMode(Mode, tokens);
+    });
+};
+
+inline std::future<void> ticker::runOnLoop(std::function<void()> command) {
+    // shared since queued commands have to be copyable
+    auto done = std::make_shared<std::promise<void>>();
+    std::future<void> result = done->get_future();
+    const bool queued =
+        commands.push([done, Command = std::move(command)]() {
+            try {
+                Command();
+                done->set_value();
+            } catch (...) { done->set_exception(std::current_exception()); };
+        });
+    if (!queued) {
+        done->set_exception(std::make_exception_ptr(
+            kc::libException("ticker has been stopped")));
+    };
+    return result;
+};
+
+inline void ticker::queueRequest(
+    REQUEST request, const std::vector<int>& instrumentTokens, MODES mode) {
+    // requests are sent in the order unsubscribe, subscribe, mode, so only
+    // their net effect is kept. e.g., unsubscribing drops a pending
+    // subscription and mode, while subscribing after unsubscribing sends both
+    // so that the instrument is subscribed again in the default mode.
+    for (const int tok : instrumentTokens) {
+        auto [it, inserted] = pendingRequests.try_emplace(tok);
+        if (inserted) { pendingTokens.push_back(tok); };
+        pendingRequest& pending = it->second;
+        switch (request) {
+            case REQUEST::SUBSCRIBE:
+                // subscribing resets the mode
+                pending.subscribe = true;
+                pending.setsMode = false;
+                break;
+            case REQUEST::UNSUBSCRIBE:
+                pending = pendingRequest {};
+                pending.unsubscribe = true;
+                break;
+            case REQUEST::MODE:
+                pending.setsMode = true;
+                pending.mode = mode;
+                break;
+        };
+    };
+
+    // a timer without a timeout fires on the next iteration of the loop, so
+    // that every request made until then is sent together
+    if (!requestTimer.isActive()) {
+        requestTimer.start(hub->getLoop(), 0, 0, [this]() { flushRequests(); });
+    };
+};
+
+inline void ticker::flushRequests() {
+    if (!isConnected()) {
+        // everything is subscribed again from `subbedInstruments` once the
+        // connection is back
+        pendingTokens.clear();
+        pendingRequests.clear();
+        return;
+    };
+    encodeRequests([this](const char* data, size_t size) {
+        ws->send(data, size, uWS::OpCode::TEXT);
+    });
+};
+
+template <class Sender>
+inline void ticker::encodeRequests(Sender&& send) {
+    const auto encodeIf = [&](std::string_view action, std::string_view mode,
+                              auto&& selected) {
+        requestTokens.clear();
+        for (const int tok : pendingTokens) {
+            if (selected(pendingRequests[tok])) {
+                requestTokens.push_back(tok);
+            };
+        };
+        encodeRequest(action, mode, requestTokens, send);
+    };
+
+    encodeIf("unsubscribe", {},
+        [](const pendingRequest& pending) { return pending.unsubscribe; });
+    encodeIf("subscribe", {},
+        [](const pendingRequest& pending) { return pending.subscribe; });
+    for (const MODES mode : { MODES::LTP, MODES::QUOTE, MODES::FULL }) {
+        encodeIf("mode", modeName(mode), [mode](const pendingRequest& pending) {
+            return pending.setsMode && pending.mode == mode;
+        });
+    };
+
+    pendingTokens.clear();
+    pendingRequests.clear();
+};
+
+template <class Sender>
+inline void ticker::encodeRequest(std::string_view action,
+    std::string_view mode, const std::vector<int>& instrumentTokens,
+    Sender& send) {
+    if (instrumentTokens.empty()) { return; };
+
+    // {"a":"<action>","v":[<tokens>]} or {"a":"mode","v":["<mode>",[<tokens>]]}
+    requestBuffer.assign(R"({"a":")");
+    requestBuffer.append(action);
+    requestBuffer.append(R"(","v":)");
+    if (!mode.empty()) {
+        requestBuffer.append(R"([")");
+        requestBuffer.append(mode);
+        requestBuffer.append(R"(",)");
+    };
+    requestBuffer.push_back('[');
+    const size_t headSize = requestBuffer.size();
+    const std::string_view tail = mode.empty() ? "]}" : "]]}";
+
+    // int32 fits in 11 characters
+    std::array<char, 11> digits {};
+    char* const first = digits.data();
+    for (const int tok : instrumentTokens) {
+        const size_t length = static_cast<size_t>(
+            std::to_chars(first, first + digits.size(), tok).ptr - first);
+        if (requestBuffer.size() > headSize &&
+            requestBuffer.size() + 1 + length + tail.size() > maxRequestSize) {
+            requestBuffer.append(tail);
+            send(requestBuffer.data(), requestBuffer.size());
+            requestBuffer.resize(headSize);
+        };
+        if (requestBuffer.size() > headSize) { requestBuffer.push_back(','); };
+        requestBuffer.append(digits.data(), length);
+    };
+    requestBuffer.append(tail);
+    send(requestBuffer.data(), requestBuffer.size());
+};
+
+inline ticker::MODES ticker::parseMode(const string& mode) {
+    if (mode == MODE_LTP) { return MODES::LTP; };
+    if (mode == MODE_QUOTE) { return MODES::QUOTE; };
+    return MODES::FULL;
+};
+
+inline const string& ticker::modeName(MODES mode) {
+    switch (mode) {
+        case MODES::LTP: return MODE_LTP;
+        case MODES::QUOTE: return MODE_QUOTE;
+        default: return MODE_FULL;
+    };
 };
 
 inline void ticker::connectInternal() {
-    hub.connect(FMT(connectUrlFmt, key, token), nullptr, {},
+    hub->connect(FMT(connectUrlFmt, key, token), nullptr, {},
         static_cast<int>(connectTimeout), group);
 };
 
 inline void ticker::reconnect() {
-    if (isConnected()) { return; };
+    // an attempt is already scheduled
+    if (isConnected() || reconnectTimer.isActive()) { return; };
     isReconnecting = true;
     reconnectTries++;
 
     if (reconnectTries <= maxReconnectTries) {
-        std::this_thread::sleep_for(std::chrono::seconds(reconnectDelay));
+        // the loop keeps running while waiting, a failed attempt comes back
+        // here through `onError`
+        reconnectTimer.start(hub->getLoop(), nextReconnectDelay(), 0, [this]() {
+            if (onTryReconnect) { onTryReconnect(this, reconnectTries); };
+            connectInternal();
+        });
         reconnectDelay = (reconnectDelay * 2 > maxReconnectDelay) ?
                              maxReconnectDelay :
                              reconnectDelay * 2;
-
-        if (onTryReconnect) { onTryReconnect(this, reconnectTries); };
-        connectInternal();
-
-        if (isConnected()) { return; };
     } else {
-        if (onReconnectFail) { onReconnectFail(this); };
         isReconnecting = false;
+        // released first, `onReconnectFail` may connect again
+        releaseLoop();
+        if (onReconnectFail) { onReconnectFail(this); };
+    };
+};
+
+inline unsigned int ticker::nextReconnectDelay() {
+    // "equal jitter", waits between half and all of the delay
+    const unsigned int delay =
+        reconnectDelay * utils::MILLISECONDS_IN_A_SECOND;
+    std::uniform_int_distribution<unsigned int> jitter(0, delay / 2);
+    return delay - jitter(reconnectJitter);
+};
+
+inline void ticker::watch() {
+    if (!isConnected()) { return; };
+    const uint64_t now = kc::tickerStats::now();
+    if (!isAlive(now)) {
+        watchdogTimeouts.fetch_add(1, std::memory_order_relaxed);
+        // a close handshake wouldn't complete on a dead connection, the
+        // socket is dropped straight away and reported as an abnormal closure
+        ws->terminate();
+        return;
+    };
+    if (pingSentTime == 0) {
+        // the pong echoes the send time back
+        std::array<char, 24> payload {};
+        std::to_chars(payload.data(), payload.data() + payload.size() - 1, now);
+        ws->ping(payload.data());
+        pingSentTime = now;
+    };
+};
+
+inline bool ticker::isAlive(uint64_t now) const {
+    if (pingSentTime != 0 && now - pingSentTime > pongTimeout) {
+        return false;
+    };
+    return now - lastBeatTime <= frameTimeout;
+};
+
+inline void ticker::processPong(
+    const char* message, size_t length, uint64_t now) {
+    uint64_t sentTime = 0;
+    // pongs of the automatic pings are empty
+    const auto result = std::from_chars(message, message + length, sentTime);
+    if (result.ec != std::errc() || sentTime != pingSentTime ||
+        sentTime == 0) {
+        return;
+    };
+    pingRtt.record(now - sentTime);
+    pingSentTime = 0;
+};
+
+inline void ticker::processMessage(
+    char* message, size_t length, uWS::OpCode opCode) {
+    processMessage(message, length, opCode, functionCallbacks { this });
+};
+
+template <class Callbacks>
+inline void ticker::processMessage(char* message, size_t length,
+    uWS::OpCode opCode, const Callbacks& callbacks) {
+    // every frame, heartbeat or not, shows that the connection is alive
+    lastBeatTime = kc::tickerStats::now();
+    if (opCode == uWS::OpCode::BINARY && hasTickConsumers(callbacks)) {
+        // a single byte is a heartbeat, which only updates `lastBeatTime`
+        if (length > 1) { processBinaryMessage(message, length, callbacks); };
+    } else if (opCode == uWS::OpCode::TEXT) {
+        processTextMessage(message, length);
     };
 };
 
-inline void ticker::processTextMessage(const string& message) {
-    rj::Document res;
-    utils::json::parse(res, message);
+inline void ticker::processTextMessage(const char* message, size_t length) {
+    // frames nothing consumes are skipped without being parsed
+    const std::string_view preType = messageType(message, length);
+    if (!preType.empty() &&
+        !((preType == "order" && (onOrderUpdate || onOrderUpdateView)) ||
+            (preType == "message" && onMessage) ||
+            (preType == "error" && onError))) {
+        return;
+    };
+
+    textBuffer.assign(
+        message, std::next(message, static_cast<ptrdiff_t>(length)));
+    textBuffer.push_back('\0');
+    if (textPool.empty()) {
+        textPool.resize(TEXT_VALUE_POOL_SIZE + TEXT_STACK_POOL_SIZE);
+    };
+    rj::MemoryPoolAllocator<> valueAllocator(
+        textPool.data(), TEXT_VALUE_POOL_SIZE);
+    rj::MemoryPoolAllocator<> stackAllocator(
+        std::next(textPool.data(), TEXT_VALUE_POOL_SIZE), TEXT_STACK_POOL_SIZE);
+    rj::GenericDocument<rj::UTF8<>, rj::MemoryPoolAllocator<>,
+        rj::MemoryPoolAllocator<>>
+        res(&valueAllocator, TEXT_STACK_CAPACITY, &stackAllocator);
+    res.ParseInsitu(textBuffer.data());
+    if (res.HasParseError()) {
+        throw libException(FMT("failed to parse json string: {0}",
+            std::string_view(message, length)));
+    };
     if (!res.IsObject()) { throw libException("Expected a JSON object"); };
 
-    auto type = utils::json::get<string>(res, "type");
+    // compared in place, nothing is allocated for it
+    std::string_view type;
+    auto typeMember = res.FindMember("type");
+    if (typeMember != res.MemberEnd() && typeMember->value.IsString()) {
+        type = std::string_view(typeMember->value.GetString(),
+            typeMember->value.GetStringLength());
+    };
     if (type.empty()) {
         throw kc::libException(
             FMT("Cannot recognize websocket message type {0}", type));
     }
+    // only order updates and errors are required to have a body
+    const auto data = [&res]() -> rj::Value& {
+        auto it = res.FindMember("data");
+        if (it == res.MemberEnd()) { throw libException("invalid body"); };
+        return it->value;
+    };
 
-    if (type == "order" && onOrderUpdate) {
-        onOrderUpdate(this, kc::postback(utils::json::extractObject(res)));
+    if (type == "order" && (onOrderUpdate || onOrderUpdateView)) {
+        rj::Value& body = data();
+        if (!body.IsObject()) { throw libException("invalid body"); };
+        const rj::Value::Object order = body.GetObject();
+        if (onOrderUpdateView) {
+            onOrderUpdateView(this, kc::postbackView(order));
+        };
+        if (onOrderUpdate) { onOrderUpdate(this, kc::postback(order)); };
     }
-    if (type == "message" && onMessage) { onMessage(this, message); };
+    if (type == "message" && onMessage) {
+        onMessage(this, string(message, length));
+    };
     if (type == "error" && onError) {
-        onError(this, 0, utils::json::extractString(res));
+        const rj::Value& body = data();
+        if (!body.IsString()) { throw libException("invalid body"); };
+        onError(this, 0, body.GetString());
     };
 };
 
-template <typename T>
-T ticker::unpack(const std::vector<char>& bytes, size_t start, size_t end) {
-    // FIXME directly iterate over bytes instead of making a copy or reversing
-    T value;
-    std::vector<char> requiredBytes(bytes.begin() + static_cast<int64_t>(start),
-        bytes.begin() + static_cast<int64_t>(end) + 1);
+inline std::string_view ticker::messageType(
+    const char* message, size_t length) {
+    static constexpr std::string_view WHITESPACE = " \t\r\n";
+    const std::string_view text(message, length);
+    // the end of the string starting at \a open, `npos` if it's cut short
+    const auto stringEnd = [&text](size_t open) {
+        for (size_t i = open + 1; i < text.size(); i++) {
+            if (text[i] == '\\') {
+                i++;
+            } else if (text[i] == '"') {
+                return i;
+            };
+        };
+        return std::string_view::npos;
+    };
 
-    // clang-format off
-        #ifndef WORDS_BIGENDIAN
-        std::reverse(requiredBytes.begin(), requiredBytes.end());
-        #endif
-    // clang-format on
+    size_t position = text.find_first_not_of(WHITESPACE);
+    if (position == std::string_view::npos || text[position] != '{') {
+        return {};
+    };
+    // only keys of the top level object count, not ones of nested objects or
+    // inside strings
+    int depth = 0;
+    bool expectsKey = false;
+    for (; position < text.size(); position++) {
+        const char c = text[position];
+        if (c == '{' || c == '[') {
+            depth++;
+            expectsKey = depth == 1;
+        } else if (c == '}' || c == ']') {
+            depth--;
+        } else if (c == ',' && depth == 1) {
+            expectsKey = true;
+        } else if (c == '"') {
+            const size_t end = stringEnd(position);
+            if (end == std::string_view::npos) { return {}; };
+            const bool isTypeKey = depth == 1 && expectsKey &&
+                                   text.substr(position, end - position + 1) ==
+                                       "\"type\"";
+            expectsKey = false;
+            position = end;
+            if (!isTypeKey) { continue; };
 
-    std::memcpy(&value, requiredBytes.data(), sizeof(T));
-    return value;
+            position = text.find_first_not_of(WHITESPACE, position + 1);
+            if (position == std::string_view::npos || text[position] != ':') {
+                return {};
+            };
+            position = text.find_first_not_of(WHITESPACE, position + 1);
+            if (position == std::string_view::npos || text[position] != '"') {
+                return {};
+            };
+            const size_t valueEnd = stringEnd(position);
+            if (valueEnd == std::string_view::npos) { return {}; };
+            const std::string_view type =
+                text.substr(position + 1, valueEnd - position - 1);
+            // escaped types are left to the parser
+            if (type.find('\\') != std::string_view::npos) { return {}; };
+            return type;
+        };
+    };
+    return {};
+};
+
+template <class Callbacks>
+inline bool ticker::hasTickConsumers(const Callbacks& callbacks) const {
+    return callbacks.hasTicks() || callbacks.hasTickViews() ||
+           callbacks.hasTickBatch() || snapshots || !tickQueues.empty();
+};
+
+inline void ticker::processBinaryMessage(char* message, size_t length) {
+    processBinaryMessage(message, length, functionCallbacks { this });
 };
 
-inline std::vector<std::vector<char>> ticker::splitPackets(
-    const std::vector<char>& bytes) {
-    const auto numberOfPackets = unpack<int16_t>(bytes, 0, 1);
-    std::vector<std::vector<char>> packets;
+template <class Callbacks>
+inline void ticker::processBinaryMessage(
+    char* message, size_t length, const Callbacks& callbacks) {
+    recordFrameStats(message, length);
+    // taken after the bookkeeping so that it isn't counted as parsing
+    const uint64_t receiveTime = statsTime();
+    uint64_t callbackTime = 0;
+    const auto timed = [&](const auto& callback) {
+        const uint64_t start = statsTime();
+        callback();
+        callbackTime += statsTime() - start;
+    };
 
-    unsigned int packetLengthStartIdx = 2;
-    for (int i = 1; i <= numberOfPackets; i++) {
-        unsigned int packetLengthEndIdx = packetLengthStartIdx + 1;
-        auto packetLength =
-            unpack<int16_t>(bytes, packetLengthStartIdx, packetLengthEndIdx);
-        packetLengthStartIdx = packetLengthEndIdx + packetLength + 1;
-        packets.emplace_back(bytes.begin() + packetLengthEndIdx + 1,
-            bytes.begin() + packetLengthStartIdx);
+    if (tickFilter != kc::TICK_FILTER::NONE) {
+        length = suppressUnchanged(message, length);
+        if (length <= 2) {
+            recordTimeStats(receiveTime, callbackTime);
+            return;
+        };
+    };
+    if (callbacks.hasTickViews()) {
+        tickViewBuffer.clear();
+        splitPackets(message, length, [&](const char* packet, size_t size) {
+            tickViewBuffer.emplace_back(packet, size);
+        });
+        timed([&]() { callbacks.tickViews(tickViewBuffer); });
     };
-    return packets;
+    if (callbacks.hasTickBatch()) {
+        parseBinaryMessage(message, length, tickBatchBuffer);
+        timed([&]() { callbacks.tickBatch(tickBatchBuffer); });
+    };
+    if (callbacks.hasTicks() || snapshots || !tickQueues.empty()) {
+        std::vector<kc::tick>& ticks =
+            (userTickBuffer != nullptr) ? *userTickBuffer : tickBuffer;
+        parseBinaryMessage(message, length, ticks);
+        if (snapshots) {
+            for (const kc::tick& Tick : ticks) { snapshots->store(Tick); };
+        };
+        for (kc::tickQueue* queue : tickQueues) {
+            for (const kc::tick& Tick : ticks) { queue->push(Tick); };
+        };
+        if (callbacks.hasTicks()) {
+            if (conflationTimer.isActive()) {
+                conflate(ticks);
+            } else {
+                timed([&]() { callbacks.ticks(ticks); });
+            };
+        };
+    };
+    recordTimeStats(receiveTime, callbackTime);
 };
 
-inline std::vector<kc::tick> ticker::parseBinaryMessage(
-    char* bytes, size_t size) {
-    static constexpr uint8_t SEGMENT_MASK = 0xff;
-    static constexpr double CDS_DIVISOR = 10000000.0;
-    static constexpr double BSECDS_DIVISOR = 10000.0;
-    static constexpr double GENERIC_DIVISOR = 100.0;
-    static constexpr size_t LTP_PACKET_SIZE = 8;
-    static constexpr size_t INDICES_QUOTE_PACKET_SIZE = 28;
-    static constexpr size_t INDICES_FULL_PACKET_SIZE = 32;
-    static constexpr size_t QUOTE_PACKET_SIZE = 44;
-    static constexpr size_t FULL_PACKET_SIZE = 184;
+inline uint64_t ticker::statsTime() {
+#ifndef KITE_DISABLE_TICKER_STATS
+    return kc::tickerStats::now();
+#else
+    return 0;
+#endif
+};
 
-    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-    std::vector<std::vector<char>> packets =
-        splitPackets(std::vector<char>(bytes, bytes + size));
-    if (packets.empty()) { return {}; };
+inline void ticker::recordFrameStats(const char* message, size_t length) {
+#ifndef KITE_DISABLE_TICKER_STATS
+    stats.frameSize.record(length);
+    if (length < 2) { return; };
+    stats.packetCount.record(unpack<uint16_t>(message, 0));
 
-    std::vector<kc::tick> ticks;
-    for (const auto& packet : packets) {
-        const size_t packetSize = packet.size();
-        const auto instrumentToken = unpack<int32_t>(packet, 0, 3);
-        // NOLINTNEXTLINE(hicpp-signed-bitwise)
-        const uint8_t segment = instrumentToken & SEGMENT_MASK;
-        const bool tradable =
-            segment != static_cast<uint8_t>(SEGMENTS::INDICES);
-        double divisor = 0.0;
-        if (segment == static_cast<uint8_t>(SEGMENTS::CDS)) {
-            divisor = CDS_DIVISOR;
-
-        } else if (segment == static_cast<uint8_t>(SEGMENTS::BSECDS)) {
-            divisor = BSECDS_DIVISOR;
+    // lag changes slowly, sampling it spares most frames a second walk over
+    // their packets and a read of the system clock
+    if (lagSampleFrames++ % kc::tickerStats::EXCHANGE_LAG_SAMPLE_INTERVAL !=
+        0) {
+        return;
+    };
+    int64_t now = -1;
+    splitPackets(message, length, [&](const char* packet, size_t size) {
+        const int32_t timestamp = internal::packet::timestamp(packet, size);
+        if (timestamp <= 0) { return; };
+        const auto segment = internal::segment::of(
+            unpack<int32_t>(packet, internal::packet::INSTRUMENT_TOKEN));
+        if (segment >= kc::tickerStats::SEGMENTS) { return; };
+        if (now < 0) {
+            now = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch())
+                      .count();
+        };
+        const int64_t lag = now - int64_t { timestamp } * 1000;
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+        stats.exchangeLag[segment].record(
+            static_cast<uint64_t>(std::max<int64_t>(lag, 0)));
+    });
+#else
+    static_cast<void>(message);
+    static_cast<void>(length);
+#endif
+};
 
-        } else {
-            divisor = GENERIC_DIVISOR;
-        }
-
-        kc::tick Tick;
-        Tick.isTradable = tradable;
-        Tick.instrumentToken = instrumentToken;
-
-        // NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
-        // LTP packet
-        if (packetSize == LTP_PACKET_SIZE) {
-            Tick.mode = MODE_LTP;
-            Tick.lastPrice = unpack<int32_t>(packet, 4, 7) / divisor;
-        } else if (packetSize == INDICES_QUOTE_PACKET_SIZE ||
-                   packetSize == INDICES_FULL_PACKET_SIZE) {
-            // indices quote and full mode
-            Tick.mode = (packetSize == INDICES_QUOTE_PACKET_SIZE) ? MODE_QUOTE :
-                                                                    MODE_FULL;
-            Tick.lastPrice = unpack<int32_t>(packet, 4, 7) / divisor;
-            Tick.ohlc.high = unpack<int32_t>(packet, 8, 11) / divisor;
-            Tick.ohlc.low = unpack<int32_t>(packet, 12, 15) / divisor;
-            Tick.ohlc.open = unpack<int32_t>(packet, 16, 19) / divisor;
-            Tick.ohlc.close = unpack<int32_t>(packet, 20, 23) / divisor;
-            Tick.netChange = unpack<int32_t>(packet, 24, 27) / divisor;
-            if (packetSize == INDICES_FULL_PACKET_SIZE) {
-                Tick.timestamp = unpack<int32_t>(packet, 28, 31);
-            }
-        } else if (packetSize == QUOTE_PACKET_SIZE ||
-                   packetSize == FULL_PACKET_SIZE) {
-            // Quote and full mode
-            Tick.mode =
-                (packetSize == QUOTE_PACKET_SIZE) ? MODE_QUOTE : MODE_FULL;
-            Tick.lastPrice = unpack<int32_t>(packet, 4, 7) / divisor;
-            Tick.lastTradedQuantity = unpack<int32_t>(packet, 8, 11);
-            Tick.averageTradePrice = unpack<int32_t>(packet, 12, 15) / divisor;
-            Tick.volumeTraded = unpack<int32_t>(packet, 16, 19);
-            Tick.totalBuyQuantity = unpack<int32_t>(packet, 20, 23);
-            Tick.totalSellQuantity = unpack<int32_t>(packet, 24, 27);
-            Tick.ohlc.open = unpack<int32_t>(packet, 28, 31) / divisor;
-            Tick.ohlc.high = unpack<int32_t>(packet, 32, 35) / divisor;
-            Tick.ohlc.low = unpack<int32_t>(packet, 36, 39) / divisor;
-            Tick.ohlc.close = unpack<int32_t>(packet, 40, 43) / divisor;
-            Tick.netChange =
-                (Tick.lastPrice - Tick.ohlc.close) * 100 / Tick.ohlc.close;
-
-            // parse full mode
-            if (packetSize == FULL_PACKET_SIZE) {
-                Tick.lastTradeTime = unpack<int32_t>(packet, 44, 47);
-                Tick.oi = unpack<int32_t>(packet, 48, 51);
-                Tick.oiDayHigh = unpack<int32_t>(packet, 52, 55);
-                Tick.oiDayLow = unpack<int32_t>(packet, 56, 59);
-                Tick.timestamp = unpack<int32_t>(packet, 60, 63);
-
-                unsigned int depthStartIdx = 64;
-                for (int i = 0; i <= 9; i++) {
-                    kc::depthWS depth;
-                    depth.quantity = unpack<int32_t>(
-                        packet, depthStartIdx, depthStartIdx + 3);
-                    depth.price = unpack<int32_t>(packet, depthStartIdx + 4,
-                                      depthStartIdx + 7) /
-                                  divisor;
-                    depth.orders = unpack<int16_t>(
-                        packet, depthStartIdx + 8, depthStartIdx + 9);
-
-                    (i >= 5) ? Tick.marketDepth.sell.emplace_back(depth) :
-                               Tick.marketDepth.buy.emplace_back(depth);
-                    depthStartIdx = depthStartIdx + 12;
-                };
+inline void ticker::recordTimeStats(
+    uint64_t receiveTime, uint64_t callbackTime) {
+#ifndef KITE_DISABLE_TICKER_STATS
+    stats.lastReceiveTime.store(receiveTime, std::memory_order_relaxed);
+    stats.parseTime.record(statsTime() - receiveTime - callbackTime);
+    stats.callbackTime.record(callbackTime);
+#else
+    static_cast<void>(receiveTime);
+    static_cast<void>(callbackTime);
+#endif
+};
+
+inline size_t ticker::suppressUnchanged(char* message, size_t length) {
+    static constexpr size_t LENGTH_SIZE = 2;
+    // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+    static constexpr unsigned int BYTE = 8;
+    if (length < LENGTH_SIZE) { return length; };
+    size_t end = LENGTH_SIZE;
+    uint16_t kept = 0;
+    splitPackets(message, length, [&](const char* packet, size_t size) {
+        if (size >= internal::packet::LTP_SIZE) {
+            const uint64_t fingerprint =
+                internal::filter::fingerprint(packet, size, tickFilter);
+            auto [it, inserted] = tickFingerprints.try_emplace(
+                unpack<int32_t>(packet, internal::packet::INSTRUMENT_TOKEN),
+                fingerprint);
+            if (!inserted && it->second == fingerprint) {
+                suppressedTicks.fetch_add(1, std::memory_order_relaxed);
+                return;
             };
+            it->second = fingerprint;
+        };
+        // packets are only ever moved towards the start, ahead of the ones
+        // that are yet to be visited
+        // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        const char* prefixed = packet - LENGTH_SIZE;
+        if (prefixed != message + end) {
+            std::memmove(message + end, prefixed, size + LENGTH_SIZE);
+        };
+        // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        end += size + LENGTH_SIZE;
+        kept++;
+    });
+    message[0] = static_cast<char>(kept >> BYTE);
+    message[1] = static_cast<char>(kept);
+    return end;
+};
+
+inline void ticker::conflate(const std::vector<kc::tick>& ticks) {
+    for (const kc::tick& Tick : ticks) {
+        // the index outlives deliveries, a position is only this instrument's
+        // if it holds this instrument's tick
+        auto [it, inserted] = conflatedIndex.try_emplace(
+            Tick.instrumentToken, conflatedTicks.size());
+        if (!inserted && it->second < conflatedTicks.size() &&
+            conflatedTicks[it->second].instrumentToken ==
+                Tick.instrumentToken) {
+            conflatedTicks[it->second] = Tick;
+            mergedTicks.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            it->second = conflatedTicks.size();
+            conflatedTicks.push_back(Tick);
         };
-        // NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
-        ticks.emplace_back(Tick);
     };
+};
+
+inline void ticker::flushConflated() {
+    if (conflatedTicks.empty()) { return; };
+    if (onTicks) { onTicks(this, conflatedTicks); };
+    // the buffer keeps its capacity and the index is kept, so conflating stops
+    // allocating once every subscribed instrument has been seen
+    conflatedTicks.clear();
+};
+
+template <typename T>
+T ticker::unpack(const char* bytes, size_t start) {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    return utils::bytes::readBigEndian<T>(bytes + start);
+};
+
+template <class Visitor>
+size_t ticker::splitPackets(const char* bytes, size_t size, Visitor&& visit) {
+    // every frame starts with the number of packets and every packet is
+    // prefixed by its length, each of which is a 2 byte integer
+    static constexpr size_t LENGTH_SIZE = 2;
+    if (size < LENGTH_SIZE) { return 0; };
+
+    const auto numberOfPackets = unpack<uint16_t>(bytes, 0);
+    size_t offset = LENGTH_SIZE;
+    for (uint16_t i = 0; i < numberOfPackets; i++) {
+        if (offset + LENGTH_SIZE > size) {
+            throw kc::libException("truncated binary message");
+        };
+        const size_t packetLength = unpack<uint16_t>(bytes, offset);
+        offset += LENGTH_SIZE;
+        if (offset + packetLength > size) {
+            throw kc::libException("truncated binary message");
+        };
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        visit(bytes + offset, packetLength);
+        offset += packetLength;
+    };
+    return numberOfPackets;
+};
+
+inline kc::tick ticker::parsePacket(const char* packet, size_t packetSize) {
+    return kc::tickView(packet, packetSize).toTick();
+};
+
+inline void ticker::parseBinaryMessage(
+    char* bytes, size_t size, std::vector<kc::tick>& ticks) {
+    // packets are decoded straight out of the frame, without copying them.
+    // clearing keeps the capacity, so a reused buffer stops allocating once it
+    // has grown to the largest frame seen.
+    ticks.clear();
+    if (size >= 2) { ticks.reserve(unpack<uint16_t>(bytes, 0)); };
+    splitPackets(bytes, size, [&](const char* packet, size_t packetSize) {
+        ticks.emplace_back(parsePacket(packet, packetSize));
+    });
+};
+
+inline std::vector<kc::tick> ticker::parseBinaryMessage(
+    char* bytes, size_t size) {
+    std::vector<kc::tick> ticks;
+    parseBinaryMessage(bytes, size, ticks);
     return ticks;
 };
 
+inline void ticker::parseBinaryMessage(
+    char* bytes, size_t size, kc::tickBatch& batch) {
+    // columns are sized upfront so that every packet is decoded straight into
+    // its row
+    batch.resize((size >= 2) ? unpack<uint16_t>(bytes, 0) : 0);
+    size_t row = 0;
+    splitPackets(bytes, size, [&](const char* packet, size_t packetSize) {
+        batch.assign(row++, packet, packetSize);
+    });
+};
+
 inline void ticker::resubInstruments() {
+    std::vector<int> instruments;
     std::vector<int> ltpInstruments;
     std::vector<int> quoteInstruments;
     std::vector<int> fullInstruments;
     for (const auto& i : subbedInstruments) {
+        instruments.push_back(i.first);
         if (i.second == MODES::LTP) { ltpInstruments.push_back(i.first); };
         if (i.second == MODES::QUOTE) { quoteInstruments.push_back(i.first); };
         if (i.second == MODES::FULL) { fullInstruments.push_back(i.first); };
     };
 
-    if (!ltpInstruments.empty()) { setMode(MODE_LTP, ltpInstruments); };
-    if (!quoteInstruments.empty()) { setMode(MODE_QUOTE, quoteInstruments); };
-    if (!fullInstruments.empty()) { setMode(MODE_FULL, fullInstruments); };
+    // a new connection has no subscriptions, and Kite ignores modes of
+    // instruments that aren't subscribed. `subbedInstruments` already holds
+    // the modes, so the requests are queued without going through
+    // `subscribe()` and `setMode()`.
+    queueRequest(REQUEST::SUBSCRIBE, instruments);
+    queueRequest(REQUEST::MODE, ltpInstruments, MODES::LTP);
+    queueRequest(REQUEST::MODE, quoteInstruments, MODES::QUOTE);
+    queueRequest(REQUEST::MODE, fullInstruments, MODES::FULL);
+};
+
+inline void ticker::processDisconnection(int code, const string& reason) {
+    ws = nullptr;
+    const bool abnormal = code != utils::ws::ERROR_CODE::NORMAL_CLOSURE;
+    // released before the callbacks, which may connect again
+    if (!abnormal || !enableReconnect) { releaseLoop(); };
+
+    if (abnormal) {
+        if (onError) { onError(this, code, reason); };
+    };
+    if (onClose) { onClose(this, code, reason); };
+    if (abnormal) {
+        if (enableReconnect && !isReconnecting) { reconnect(); };
+    };
 };
 
-inline void ticker::assignCallbacks() {
+template <class Callbacks>
+inline void ticker::assignCallbacks(Callbacks callbacks) {
     // NOLINTNEXTLINE(readability-implicit-bool-conversion)
     group->onConnection(
         [&](uWS::WebSocket<uWS::CLIENT>* Ws, uWS::HttpRequest /*req*/) {
             ws = Ws;
             //! not setting this time would prompt reconnecting immediately even
             //! when conected since pongTime would be far back
-            lastPongTime = std::chrono::system_clock::now();
+            lastBeatTime = kc::tickerStats::now();
+            pingSentTime = 0;
 
             reconnectTries = 0;
             reconnectDelay = initReconnectDelay;
@@ -386,27 +1028,27 @@ inline void ticker::assignCallbacks() {
         });
 
     // NOLINTNEXTLINE(readability-implicit-bool-conversion)
-    group->onMessage([&](uWS::WebSocket<uWS::CLIENT>* /*ws*/, char* message,
-                         size_t length, uWS::OpCode opCode) {
-        if (opCode == uWS::OpCode::BINARY && onTicks) {
-            if (length == 1) {
-                // is a heartbeat
-                lastBeatTime = std::chrono::system_clock::now();
-            } else {
-                onTicks(this, parseBinaryMessage(message, length));
-            };
-        } else if (opCode == uWS::OpCode::TEXT) {
-            processTextMessage(string(message, length));
+    group->onMessage([this, callbacks](uWS::WebSocket<uWS::CLIENT>* /*ws*/,
+                         char* message, size_t length, uWS::OpCode opCode) {
+#ifndef KITE_DISABLE_JOURNAL
+        if (journal) {
+            // recorded before processing, which may compact the frame
+            journal->append(static_cast<uint8_t>(opCode), message, length,
+                kc::tickJournal::now());
         };
+#endif
+        processMessage(message, length, opCode, callbacks);
     });
 
     // NOLINTNEXTLINE(readability-implicit-bool-conversion)
-    group->onPong([&](uWS::WebSocket<uWS::CLIENT>* /*ws*/, char* /*message*/,
-                      size_t /*length*/) {
-        lastPongTime = std::chrono::system_clock::now();
+    group->onPong([&](uWS::WebSocket<uWS::CLIENT>* /*ws*/, char* message,
+                      size_t length) {
+        processPong(message, length, kc::tickerStats::now());
     });
 
     group->onError([&](void*) {
+        // a connection that's closed is handled once it's disconnected
+        if (!enableReconnect && !isConnected()) { releaseLoop(); };
         if (onConnectError) { onConnectError(this); }
         // close the non-responsive connection
         if (isConnected()) { ws->close(utils::ws::ERROR_CODE::NO_REASON); };
@@ -416,15 +1058,7 @@ inline void ticker::assignCallbacks() {
     // NOLINTNEXTLINE(readability-implicit-bool-conversion)
     group->onDisconnection([&](uWS::WebSocket<uWS::CLIENT>* /*ws*/, int code,
                                char* reason, size_t length) {
-        ws = nullptr;
-
-        if (code != utils::ws::ERROR_CODE::NORMAL_CLOSURE) {
-            if (onError) { onError(this, code, string(reason, length)); };
-        };
-        if (onClose) { onClose(this, code, string(reason, length)); };
-        if (code != utils::ws::ERROR_CODE::NORMAL_CLOSURE) {
-            if (enableReconnect && !isReconnecting) { reconnect(); };
-        };
+        processDisconnection(code, string(reason, length));
     });
 
     group->startAutoPing(static_cast<int>(pingInterval), pingMessage);
@@ -0,0 +1,445 @@
+/*
+ *  Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+ *  SPDX-License-Identifier: MIT
+ *
+ *  Copyright (c) 2020-2022 Bhumit Attarde
+ *
+ *  Permission is hereby  granted, free of charge, to any  person obtaining a
+ * copy of this software and associated  documentation files (the "Software"),
+ * to deal in the Software  without restriction, including without  limitation
+ * the rights to  use, copy,  modify, merge,  publish, distribute,  sublicense,
+ * and/or  sell copies  of  the Software,  and  to  permit persons  to  whom the
+ * Software  is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS
+ * OR IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN
+ * NO EVENT  SHALL THE AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY
+ * CLAIM,  DAMAGES OR  OTHER LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT
+ * OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// segments are memory mapped with POSIX calls
+#if defined(_WIN32) && !defined(KITE_DISABLE_JOURNAL)
+#define KITE_DISABLE_JOURNAL
+#endif
+
+#ifndef KITE_DISABLE_JOURNAL
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "../exceptions.hpp"
+#include "../utils.hpp"
+
+#ifndef KITE_DISABLE_JOURNAL
+namespace kiteconnect {
+
+using std::string;
+namespace kc = kiteconnect;
+
+///
+/// @brief Append only journal of websocket frames, written to memory mapped
+///        segment files.
+///
+/// Every segment is a file named `<prefix>.<index>` (index padded to 6
+/// digits) that starts with a `SEGMENT_HEADER_SIZE` byte header, followed by
+/// records of a `recordHeader` and the frame, padded to `RECORD_ALIGNMENT`.
+/// Records are written in native byte order and a header whose receive time is
+/// `0` ends a segment.
+///
+/// `append()` only copies the frame into mapped memory. A background thread
+/// maps (and pre-faults) the next segment ahead of time, flushes written pages
+/// and closes full segments, so the caller never waits on disk I/O unless
+/// segments are filled faster than they can be created. `append()` must be
+/// called from a single thread.
+///
+/// Only available on POSIX platforms, not if `KITE_DISABLE_JOURNAL` is defined.
+///
+class tickJournal {
+  public:
+    struct recordHeader {
+        uint64_t receiveTime; // ns, monotonic clock
+        uint32_t length;
+        uint8_t opCode;
+        std::array<uint8_t, 3> reserved;
+    };
+    static_assert(sizeof(recordHeader) == 16, "unexpected record header size");
+
+    static constexpr size_t DEFAULT_SEGMENT_SIZE = 64 * 1024 * 1024;
+    static constexpr unsigned int DEFAULT_FLUSH_INTERVAL = 100; // ms
+    static constexpr size_t SEGMENT_HEADER_SIZE = 16;
+    static constexpr size_t RECORD_ALIGNMENT = 8;
+    static constexpr std::array<char, 8> MAGIC = { 'K', 'I', 'T', 'E', 'J',
+        'R', 'N', 'L' };
+    static constexpr uint32_t VERSION = 1;
+
+    ///
+    /// @brief Construct a new journal and create its first segment.
+    ///
+    /// @param PathPrefix    path segment files are named after, existing
+    ///                      segments are overwritten
+    /// @param SegmentSize   size of a segment file (bytes), should be a
+    ///                      multiple of the page size
+    /// @param FlushInterval interval between flushes of written pages (ms)
+    ///
+    /// @throw libException if the first segment can't be created
+    ///
+    explicit tickJournal(string PathPrefix,
+        size_t SegmentSize = DEFAULT_SEGMENT_SIZE,
+        unsigned int FlushInterval = DEFAULT_FLUSH_INTERVAL)
+        : prefix(std::move(PathPrefix)), segmentSize(SegmentSize),
+          flushInterval(FlushInterval) {
+        if (segmentSize <= SEGMENT_HEADER_SIZE + sizeof(recordHeader)) {
+            throw libException("journal segment size is too small");
+        };
+        active = openSegment(prefix, 0, segmentSize);
+        if (active.data == nullptr) {
+            throw libException(
+                FMT("failed to create journal segment {0}", active.path));
+        };
+        nextIndex = 1;
+        flusher = std::thread([this]() { flush(); });
+    };
+
+    tickJournal(const tickJournal&) = delete;
+    tickJournal& operator=(const tickJournal&) = delete;
+    tickJournal(tickJournal&&) = delete;
+    tickJournal& operator=(tickJournal&&) = delete;
+
+    ~tickJournal() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (active.data != nullptr) {
+                active.used = offset;
+                retired.push_back(active);
+                active = {};
+            };
+            stopping = true;
+        };
+        wakeFlusher.notify_one();
+        flusher.join();
+        // prepared but never written to
+        if (spare.data != nullptr) {
+            closeSegment(spare);
+            ::unlink(spare.path.c_str());
+        };
+    };
+
+    ///
+    /// @brief Append a frame.
+    ///
+    /// @param opCode      websocket opcode of the frame
+    /// @param data        frame payload
+    /// @param length      length of \a data
+    /// @param receiveTime time the frame was received at (ns, monotonic
+    ///                    clock), must not be `0`
+    ///
+    /// @return bool `false` if the frame was dropped because it doesn't fit
+    ///              in a segment or a segment couldn't be created
+    ///
+    bool append(
+        uint8_t opCode, const char* data, size_t length, uint64_t receiveTime) {
+        const size_t size = recordSize(length);
+        if (size > segmentSize - SEGMENT_HEADER_SIZE) {
+            droppedRecords.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        };
+        if (active.data == nullptr || offset + size > segmentSize) {
+            if (!rotate()) {
+                droppedRecords.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            };
+        };
+
+        recordHeader header {};
+        header.receiveTime = receiveTime;
+        header.length = static_cast<uint32_t>(length);
+        header.opCode = opCode;
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        char* record = active.data + offset;
+        std::memcpy(record, &header, sizeof(header));
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        std::memcpy(record + sizeof(header), data, length);
+        offset += size;
+        written.store(offset, std::memory_order_release);
+        records.fetch_add(1, std::memory_order_relaxed);
+        bytes.fetch_add(size, std::memory_order_relaxed);
+        return true;
+    };
+
+    /// @brief Current time of the clock receive times are measured with (ns).
+    static uint64_t now() {
+        return static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch())
+                .count());
+    };
+
+    /// @brief Get the number of appended frames.
+    uint64_t recordCount() const {
+        return records.load(std::memory_order_relaxed);
+    };
+
+    /// @brief Get the number of bytes appended, including record headers.
+    uint64_t bytesWritten() const {
+        return bytes.load(std::memory_order_relaxed);
+    };
+
+    /// @brief Get the number of frames that were dropped.
+    uint64_t droppedCount() const {
+        return droppedRecords.load(std::memory_order_relaxed);
+    };
+
+    /// @brief Get the number of times `append()` had to wait for a segment to
+    ///        be created.
+    uint64_t stallCount() const {
+        return stalls.load(std::memory_order_relaxed);
+    };
+
+    /// @brief Get the path of a segment.
+    static string segmentPath(const string& prefix, uint64_t index) {
+        return FMT("{0}.{1:06d}", prefix, index);
+    };
+
+    ///
+    /// @brief Read every record of a segment.
+    ///
+    /// @param path  path of the segment
+    /// @param visit called with the `recordHeader` and payload (`const char*`)
+    ///              of every record, in order
+    ///
+    /// @return bool `false` if the segment couldn't be read or isn't a journal
+    ///              segment
+    ///
+    template <class Visitor>
+    static bool readSegment(const string& path, Visitor&& visit) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) { return false; };
+        const std::vector<char> buffer((std::istreambuf_iterator<char>(file)),
+            std::istreambuf_iterator<char>());
+        if (buffer.size() < SEGMENT_HEADER_SIZE ||
+            !std::equal(MAGIC.begin(), MAGIC.end(), buffer.begin())) {
+            return false;
+        };
+
+        size_t position = SEGMENT_HEADER_SIZE;
+        while (position + sizeof(recordHeader) <= buffer.size()) {
+            recordHeader header {};
+            std::memcpy(&header, &buffer[position], sizeof(header));
+            if (header.receiveTime == 0 ||
+                position + sizeof(header) + header.length > buffer.size()) {
+                break;
+            };
+            visit(static_cast<const recordHeader&>(header),
+                &buffer[position + sizeof(header)]);
+            position += recordSize(header.length);
+        };
+        return true;
+    };
+
+    ///
+    /// @brief Read every record of a journal, segment by segment.
+    ///
+    /// @param prefix path prefix the journal was created with
+    /// @param visit  called like in `readSegment()`
+    ///
+    /// @return uint64_t number of segments read
+    ///
+    template <class Visitor>
+    static uint64_t read(const string& prefix, Visitor&& visit) {
+        uint64_t index = 0;
+        while (readSegment(segmentPath(prefix, index), visit)) { index++; };
+        return index;
+    };
+
+  private:
+    struct segment {
+        string path;
+        int fd = -1;
+        char* data = nullptr;
+        size_t size = 0;
+        size_t used = 0;
+    };
+
+    const string prefix;
+    const size_t segmentSize;
+    const unsigned int flushInterval;
+    // only touched by the appending thread
+    segment active;
+    size_t offset = SEGMENT_HEADER_SIZE;
+    // shared with the flusher, guarded by mutex
+    std::mutex mutex;
+    std::condition_variable wakeFlusher;
+    std::condition_variable spareReady;
+    segment spare;
+    std::deque<segment> retired;
+    uint64_t nextIndex = 0;
+    size_t flushed = 0;
+    bool failed = false;
+    bool stopping = false;
+    std::atomic<size_t> written { SEGMENT_HEADER_SIZE };
+    std::atomic<uint64_t> records { 0 };
+    std::atomic<uint64_t> bytes { 0 };
+    std::atomic<uint64_t> droppedRecords { 0 };
+    std::atomic<uint64_t> stalls { 0 };
+    std::thread flusher;
+
+    static constexpr size_t recordSize(size_t length) {
+        return (sizeof(recordHeader) + length + RECORD_ALIGNMENT - 1) &
+               ~(RECORD_ALIGNMENT - 1);
+    };
+
+    // swaps the active segment for the prepared one
+    bool rotate() {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (spare.data == nullptr && !failed) {
+            stalls.fetch_add(1, std::memory_order_relaxed);
+            wakeFlusher.notify_one();
+            spareReady.wait(
+                lock, [this]() { return spare.data != nullptr || failed; });
+        };
+        if (active.data != nullptr) {
+            active.used = offset;
+            retired.push_back(active);
+            active = {};
+        };
+        if (spare.data == nullptr) { return false; };
+
+        active = std::move(spare);
+        spare = {};
+        offset = SEGMENT_HEADER_SIZE;
+        flushed = SEGMENT_HEADER_SIZE;
+        written.store(offset, std::memory_order_relaxed);
+        lock.unlock();
+        wakeFlusher.notify_one();
+        return true;
+    };
+
+    // runs on the flusher thread
+    void flush() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            if (spare.data == nullptr && !failed && !stopping) {
+                const uint64_t index = nextIndex++;
+                lock.unlock();
+                segment next = openSegment(prefix, index, segmentSize);
+                lock.lock();
+                if (next.data == nullptr) {
+                    failed = true;
+                } else {
+                    spare = std::move(next);
+                };
+                spareReady.notify_all();
+            };
+
+            while (!retired.empty()) {
+                segment full = std::move(retired.front());
+                retired.pop_front();
+                lock.unlock();
+                closeSegment(full);
+                lock.lock();
+            };
+
+            // written pages are flushed asynchronously, the active segment
+            // can't be unmapped while the lock is held
+            const size_t end = written.load(std::memory_order_acquire);
+            if (active.data != nullptr && end > flushed) {
+                const size_t page = pageSize();
+                const size_t begin = flushed - flushed % page;
+                ::msync(std::next(active.data, static_cast<ptrdiff_t>(begin)),
+                    end - begin, MS_ASYNC);
+                flushed = end;
+            };
+
+            if (stopping) { return; };
+            wakeFlusher.wait_for(lock,
+                std::chrono::milliseconds(flushInterval), [this]() {
+                    return stopping || !retired.empty() ||
+                           (spare.data == nullptr && !failed);
+                });
+        };
+    };
+
+    static size_t pageSize() {
+        static const auto size = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+        return size;
+    };
+
+    // creates, sizes and maps a segment, `data` is null on failure
+    static segment openSegment(
+        const string& prefix, uint64_t index, size_t size) {
+        segment seg;
+        seg.path = segmentPath(prefix, index);
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+        seg.fd = ::open(seg.path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (seg.fd < 0) { return seg; };
+        if (::ftruncate(seg.fd, static_cast<off_t>(size)) != 0) {
+            ::close(seg.fd);
+            seg.fd = -1;
+            return seg;
+        };
+
+        int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+        // fault the pages in here rather than on the appending thread
+        flags |= MAP_POPULATE;
+#endif
+        void* mapped =
+            ::mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, seg.fd, 0);
+        if (mapped == MAP_FAILED) {
+            ::close(seg.fd);
+            seg.fd = -1;
+            return seg;
+        };
+        seg.data = static_cast<char*>(mapped);
+        seg.size = size;
+        seg.used = size;
+
+        std::array<char, SEGMENT_HEADER_SIZE> header {};
+        std::copy(MAGIC.begin(), MAGIC.end(), header.begin());
+        std::memcpy(&header[MAGIC.size()], &VERSION, sizeof(VERSION));
+        std::memcpy(seg.data, header.data(), header.size());
+        return seg;
+    };
+
+    // flushes, unmaps and trims a segment to its used size
+    static void closeSegment(segment& seg) {
+        if (seg.data == nullptr) { return; };
+        ::msync(seg.data, seg.used, MS_SYNC);
+        ::munmap(seg.data, seg.size);
+        seg.data = nullptr;
+        // if trimming fails, the zeroed tail still ends the segment
+        const int trimmed = ::ftruncate(seg.fd, static_cast<off_t>(seg.used));
+        static_cast<void>(trimmed);
+        ::close(seg.fd);
+        seg.fd = -1;
+    };
+};
+
+} // namespace kiteconnect
+#endif // KITE_DISABLE_JOURNAL
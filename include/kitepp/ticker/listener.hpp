@@ -0,0 +1,131 @@
+/*
+ *  Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+ *  SPDX-License-Identifier: MIT
+ *
+ *  Copyright (c) 2020-2022 Bhumit Attarde
+ *
+ *  Permission is hereby  granted, free of charge, to any  person obtaining a
+ * copy of this software and associated  documentation files (the "Software"),
+ * to deal in the Software  without restriction, including without  limitation
+ * the rights to  use, copy,  modify, merge,  publish, distribute,  sublicense,
+ * and/or  sell copies  of  the Software,  and  to  permit persons  to  whom the
+ * Software  is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS
+ * OR IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN
+ * NO EVENT  SHALL THE AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY
+ * CLAIM,  DAMAGES OR  OTHER LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT
+ * OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "../responses/responses.hpp"
+#include "batch.hpp"
+#include "packet.hpp"
+
+namespace kiteconnect {
+
+using std::string;
+namespace kc = kiteconnect;
+
+class ticker;
+
+///
+/// @brief Base of listeners whose handlers are bound to a `ticker` at compile
+///        time, with `ticker::connect(Listener&)`.
+///
+/// A listener derives from `tickerListener<Listener>` and defines the
+/// handlers it needs with the same signatures as below. Tick handlers are
+/// called directly from `ticker`'s frame processing, the others through the
+/// `std::function` callbacks. Handlers that aren't defined aren't called.
+///
+/// \code
+/// struct strategy : kc::tickerListener<strategy> {
+///     void onTicks(kc::ticker* ws, const std::vector<kc::tick>& ticks) {}
+/// };
+/// \endcode
+///
+template <class Listener>
+class tickerListener {
+  public:
+    void onConnect(ticker* /*ws*/) {};
+    void onTicks(ticker* /*ws*/, const std::vector<kc::tick>& /*ticks*/) {};
+    void onTickViews(
+        ticker* /*ws*/, const std::vector<kc::tickView>& /*ticks*/) {};
+    void onTickBatch(ticker* /*ws*/, const kc::tickBatch& /*batch*/) {};
+    void onOrderUpdate(ticker* /*ws*/, const kc::postback& /*postback*/) {};
+    void onOrderUpdateView(
+        ticker* /*ws*/, const kc::postbackView& /*postback*/) {};
+    void onMessage(ticker* /*ws*/, const string& /*message*/) {};
+    void onError(ticker* /*ws*/, int /*code*/, const string& /*message*/) {};
+    void onConnectError(ticker* /*ws*/) {};
+    void onTryReconnect(ticker* /*ws*/, unsigned int /*attemptCount*/) {};
+    void onReconnectFail(ticker* /*ws*/) {};
+    void onClose(ticker* /*ws*/, int /*code*/, const string& /*message*/) {};
+};
+
+namespace internal {
+
+template <class Handler>
+struct handlerClass;
+
+template <class R, class C, class... Args>
+struct handlerClass<R (C::*)(Args...)> {
+    using type = C;
+};
+
+template <class R, class C, class... Args>
+struct handlerClass<R (C::*)(Args...) const> {
+    using type = C;
+};
+
+// a handler the listener doesn't define resolves to tickerListener's
+template <class Listener, class Handler>
+constexpr bool definesHandler = !std::is_same_v<
+    typename handlerClass<Handler>::type, tickerListener<Listener>>;
+
+// which handlers a listener defines
+template <class Listener>
+struct listenerHandlers {
+    static_assert(std::is_base_of_v<tickerListener<Listener>, Listener>,
+        "listeners have to derive from kc::tickerListener<Listener>");
+
+    static constexpr bool ON_CONNECT =
+        definesHandler<Listener, decltype(&Listener::onConnect)>;
+    static constexpr bool ON_TICKS =
+        definesHandler<Listener, decltype(&Listener::onTicks)>;
+    static constexpr bool ON_TICK_VIEWS =
+        definesHandler<Listener, decltype(&Listener::onTickViews)>;
+    static constexpr bool ON_TICK_BATCH =
+        definesHandler<Listener, decltype(&Listener::onTickBatch)>;
+    static constexpr bool ON_ORDER_UPDATE =
+        definesHandler<Listener, decltype(&Listener::onOrderUpdate)>;
+    static constexpr bool ON_ORDER_UPDATE_VIEW =
+        definesHandler<Listener, decltype(&Listener::onOrderUpdateView)>;
+    static constexpr bool ON_MESSAGE =
+        definesHandler<Listener, decltype(&Listener::onMessage)>;
+    static constexpr bool ON_ERROR =
+        definesHandler<Listener, decltype(&Listener::onError)>;
+    static constexpr bool ON_CONNECT_ERROR =
+        definesHandler<Listener, decltype(&Listener::onConnectError)>;
+    static constexpr bool ON_TRY_RECONNECT =
+        definesHandler<Listener, decltype(&Listener::onTryReconnect)>;
+    static constexpr bool ON_RECONNECT_FAIL =
+        definesHandler<Listener, decltype(&Listener::onReconnectFail)>;
+    static constexpr bool ON_CLOSE =
+        definesHandler<Listener, decltype(&Listener::onClose)>;
+};
+
+} // namespace internal
+
+} // namespace kiteconnect
@@ -0,0 +1,377 @@
+/*
+ *  Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+ *  SPDX-License-Identifier: MIT
+ *
+ *  Copyright (c) 2020-2022 Bhumit Attarde
+ *
+ *  Permission is hereby  granted, free of charge, to any  person obtaining a
+ * copy of this software and associated  documentation files (the "Software"),
+ * to deal in the Software  without restriction, including without  limitation
+ * the rights to  use, copy,  modify, merge,  publish, distribute,  sublicense,
+ * and/or  sell copies  of  the Software,  and  to  permit persons  to  whom the
+ * Software  is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS
+ * OR IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN
+ * NO EVENT  SHALL THE AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY
+ * CLAIM,  DAMAGES OR  OTHER LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT
+ * OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <algorithm> //copy
+#include <cstddef>
+#include <cstdint>
+
+#include "../price.hpp"
+#include "../responses/ws.hpp"
+#include "../utils.hpp"
+#include "depth.hpp"
+
+namespace kiteconnect {
+
+namespace kc = kiteconnect;
+
+namespace internal::packet {
+
+namespace utils = kc::internal::utils;
+
+// packet sizes, each of which corresponds to a mode
+constexpr size_t LTP_SIZE = 8;
+constexpr size_t INDICES_QUOTE_SIZE = 28;
+constexpr size_t INDICES_FULL_SIZE = 32;
+constexpr size_t QUOTE_SIZE = 44;
+constexpr size_t FULL_SIZE = 184;
+
+// offsets of fields common to all packets
+constexpr size_t INSTRUMENT_TOKEN = 0;
+constexpr size_t LAST_PRICE = 4;
+
+// offsets of fields in indices packets
+constexpr size_t INDICES_HIGH = 8;
+constexpr size_t INDICES_LOW = 12;
+constexpr size_t INDICES_OPEN = 16;
+constexpr size_t INDICES_CLOSE = 20;
+constexpr size_t INDICES_NET_CHANGE = 24;
+constexpr size_t INDICES_TIMESTAMP = 28;
+
+// offsets of fields in quote & full packets
+constexpr size_t LAST_TRADED_QUANTITY = 8;
+constexpr size_t AVERAGE_TRADE_PRICE = 12;
+constexpr size_t VOLUME_TRADED = 16;
+constexpr size_t TOTAL_BUY_QUANTITY = 20;
+constexpr size_t TOTAL_SELL_QUANTITY = 24;
+constexpr size_t OPEN = 28;
+constexpr size_t HIGH = 32;
+constexpr size_t LOW = 36;
+constexpr size_t CLOSE = 40;
+constexpr size_t LAST_TRADE_TIME = 44;
+constexpr size_t OI = 48;
+constexpr size_t OI_DAY_HIGH = 52;
+constexpr size_t OI_DAY_LOW = 56;
+constexpr size_t TIMESTAMP = 60;
+constexpr size_t DEPTH = 64;
+
+/// Divisor prices of an instrument's segment are scaled by.
+inline constexpr double divisor(int32_t instrumentToken) {
+    return static_cast<double>(kc::priceScale(instrumentToken));
+}
+
+inline constexpr bool isTradable(int32_t instrumentToken) {
+    return internal::segment::of(instrumentToken) !=
+           static_cast<uint8_t>(internal::segment::SEGMENTS::INDICES);
+}
+
+template <class T>
+inline T read(const char* packet, size_t offset) {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    return utils::bytes::readBigEndian<T>(packet + offset);
+}
+
+// the decoders below are shared by `tickView`, `tickView::toTick()` and
+// `tickBatch`, fields a packet doesn't have are returned as `-1`
+
+inline constexpr bool isFull(size_t packetSize) {
+    return packetSize == FULL_SIZE;
+}
+
+inline constexpr bool isQuote(size_t packetSize) {
+    return packetSize == QUOTE_SIZE || isFull(packetSize);
+}
+
+inline constexpr bool isIndex(size_t packetSize) {
+    return packetSize == INDICES_QUOTE_SIZE || packetSize == INDICES_FULL_SIZE;
+}
+
+inline constexpr TICK_MODE modeOf(size_t packetSize) {
+    switch (packetSize) {
+        case LTP_SIZE: return TICK_MODE::LTP;
+        case INDICES_QUOTE_SIZE:
+        case QUOTE_SIZE: return TICK_MODE::QUOTE;
+        case INDICES_FULL_SIZE:
+        case FULL_SIZE: return TICK_MODE::FULL;
+        default: return TICK_MODE::UNKNOWN;
+    };
+}
+
+inline int32_t quoteField(
+    const char* packet, size_t packetSize, size_t offset) {
+    return isQuote(packetSize) ? read<int32_t>(packet, offset) : -1;
+}
+
+inline int32_t fullField(const char* packet, size_t packetSize, size_t offset) {
+    return isFull(packetSize) ? read<int32_t>(packet, offset) : -1;
+}
+
+inline Price priceAt(const char* packet, size_t offset, double divisor) {
+    return internal::fromScaled(read<int32_t>(packet, offset), divisor);
+}
+
+inline int32_t timestamp(const char* packet, size_t packetSize) {
+    if (packetSize == INDICES_FULL_SIZE) {
+        return read<int32_t>(packet, INDICES_TIMESTAMP);
+    };
+    return fullField(packet, packetSize, TIMESTAMP);
+}
+
+inline kc::tick::OHLC ohlc(
+    const char* packet, size_t packetSize, double divisor) {
+    kc::tick::OHLC OHLC;
+    if (isIndex(packetSize)) {
+        OHLC.open = priceAt(packet, INDICES_OPEN, divisor);
+        OHLC.high = priceAt(packet, INDICES_HIGH, divisor);
+        OHLC.low = priceAt(packet, INDICES_LOW, divisor);
+        OHLC.close = priceAt(packet, INDICES_CLOSE, divisor);
+    } else if (isQuote(packetSize)) {
+        OHLC.open = priceAt(packet, OPEN, divisor);
+        OHLC.high = priceAt(packet, HIGH, divisor);
+        OHLC.low = priceAt(packet, LOW, divisor);
+        OHLC.close = priceAt(packet, CLOSE, divisor);
+    };
+    return OHLC;
+}
+
+inline double netChange(const char* packet, size_t packetSize, double divisor) {
+    if (isIndex(packetSize)) {
+        return read<int32_t>(packet, INDICES_NET_CHANGE) / divisor;
+    };
+    if (!isQuote(packetSize)) { return -1; };
+    const auto lastPrice =
+        static_cast<double>(priceAt(packet, LAST_PRICE, divisor));
+    const auto close = static_cast<double>(priceAt(packet, CLOSE, divisor));
+    // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+    return (lastPrice - close) * 100 / close;
+}
+
+// `entry` counts bids first, then offers
+inline depthWS depthEntry(
+    const char* packet, size_t packetSize, size_t entry, double divisor) {
+    depthWS Depth;
+    if (!isFull(packetSize) || entry >= internal::depth::LEVELS) {
+        return Depth;
+    };
+    const size_t offset = DEPTH + (entry * internal::depth::ENTRY_SIZE);
+    Depth.quantity = read<int32_t>(packet, offset);
+    Depth.price = priceAt(packet, offset + 4, divisor);
+    Depth.orders = read<int16_t>(packet, offset + 8);
+    return Depth;
+}
+
+} // namespace internal::packet
+
+///
+/// @brief Lightweight view over a single tick packet of a binary frame.
+///
+/// Nothing is decoded upfront, each accessor decodes its field from the frame
+/// when it's called. Fields that aren't sent in the packet's mode are returned
+/// as `-1`, same as `tick`. A view doesn't own the frame and is only valid
+/// until the callback it was passed to returns. Use `toTick()` to keep a copy.
+///
+class tickView {
+  public:
+    tickView() = default;
+
+    tickView(const char* Packet, size_t PacketSize)
+        : bytes(Packet), packetSize(PacketSize) {};
+
+    /// @brief Raw bytes of the packet.
+    [[nodiscard]] const char* data() const { return bytes; };
+
+    /// @brief Size of the packet in bytes.
+    [[nodiscard]] size_t size() const { return packetSize; };
+
+    [[nodiscard]] int32_t instrumentToken() const {
+        if (packetSize < internal::packet::LTP_SIZE) { return -1; };
+        return read<int32_t>(internal::packet::INSTRUMENT_TOKEN);
+    };
+
+    [[nodiscard]] TICK_MODE mode() const {
+        return internal::packet::modeOf(packetSize);
+    };
+
+    [[nodiscard]] bool isTradable() const {
+        return packetSize >= internal::packet::LTP_SIZE &&
+               internal::packet::isTradable(instrumentToken());
+    };
+
+    [[nodiscard]] Price lastPrice() const {
+        if (packetSize < internal::packet::LTP_SIZE) { return -1; };
+        return price(internal::packet::LAST_PRICE);
+    };
+
+    [[nodiscard]] int32_t lastTradedQuantity() const {
+        return quoteField(internal::packet::LAST_TRADED_QUANTITY);
+    };
+
+    [[nodiscard]] Price averageTradePrice() const {
+        return internal::packet::isQuote(packetSize) ?
+                   price(internal::packet::AVERAGE_TRADE_PRICE) :
+                   -1;
+    };
+
+    [[nodiscard]] int32_t volumeTraded() const {
+        return quoteField(internal::packet::VOLUME_TRADED);
+    };
+
+    [[nodiscard]] int32_t totalBuyQuantity() const {
+        return quoteField(internal::packet::TOTAL_BUY_QUANTITY);
+    };
+
+    [[nodiscard]] int32_t totalSellQuantity() const {
+        return quoteField(internal::packet::TOTAL_SELL_QUANTITY);
+    };
+
+    [[nodiscard]] kc::tick::OHLC ohlc() const {
+        return internal::packet::ohlc(bytes, packetSize, divisor());
+    };
+
+    [[nodiscard]] double netChange() const {
+        return internal::packet::netChange(bytes, packetSize, divisor());
+    };
+
+    [[nodiscard]] int32_t lastTradeTime() const {
+        return fullField(internal::packet::LAST_TRADE_TIME);
+    };
+
+    [[nodiscard]] int32_t oi() const {
+        return fullField(internal::packet::OI);
+    };
+
+    [[nodiscard]] int32_t oiDayHigh() const {
+        return fullField(internal::packet::OI_DAY_HIGH);
+    };
+
+    [[nodiscard]] int32_t oiDayLow() const {
+        return fullField(internal::packet::OI_DAY_LOW);
+    };
+
+    [[nodiscard]] int32_t timestamp() const {
+        return internal::packet::timestamp(bytes, packetSize);
+    };
+
+    ///
+    /// @brief Decode a single market depth entry.
+    ///
+    /// @param level level of the entry, `0` being the best bid
+    ///
+    [[nodiscard]] depthWS buy(size_t level) const { return depth(level); };
+
+    ///
+    /// @brief Decode a single market depth entry.
+    ///
+    /// @param level level of the entry, `0` being the best offer
+    ///
+    [[nodiscard]] depthWS sell(size_t level) const {
+        return depth(level + kc::tick::DEPTH_LEVELS);
+    };
+
+    /// @brief Decode every field of the packet.
+    [[nodiscard]] kc::tick toTick() const;
+
+  private:
+    const char* bytes = nullptr;
+    size_t packetSize = 0;
+
+    template <class T>
+    [[nodiscard]] T read(size_t offset) const {
+        return internal::packet::read<T>(bytes, offset);
+    };
+
+    [[nodiscard]] double divisor() const {
+        return internal::packet::divisor(instrumentToken());
+    };
+
+    [[nodiscard]] Price price(size_t offset) const {
+        return internal::packet::priceAt(bytes, offset, divisor());
+    };
+
+    [[nodiscard]] int32_t quoteField(size_t offset) const {
+        return internal::packet::quoteField(bytes, packetSize, offset);
+    };
+
+    [[nodiscard]] int32_t fullField(size_t offset) const {
+        return internal::packet::fullField(bytes, packetSize, offset);
+    };
+
+    [[nodiscard]] depthWS depth(size_t entry) const {
+        return internal::packet::depthEntry(
+            bytes, packetSize, entry, divisor());
+    };
+};
+
+inline kc::tick tickView::toTick() const {
+    namespace packet = internal::packet;
+    kc::tick Tick;
+    // packets shorter than the smallest (LTP) packet carry nothing we know of
+    if (packetSize < packet::LTP_SIZE) { return Tick; };
+
+    // unlike the accessors, the divisor is looked up only once
+    const auto token = read<int32_t>(packet::INSTRUMENT_TOKEN);
+    const double divisor = packet::divisor(token);
+    const auto priceAt = [&](size_t offset) {
+        return packet::priceAt(bytes, offset, divisor);
+    };
+
+    Tick.isTradable = packet::isTradable(token);
+    Tick.instrumentToken = token;
+    Tick.mode = mode();
+    Tick.lastPrice = priceAt(packet::LAST_PRICE);
+    Tick.ohlc = packet::ohlc(bytes, packetSize, divisor);
+    Tick.netChange = packet::netChange(bytes, packetSize, divisor);
+    Tick.timestamp = packet::timestamp(bytes, packetSize);
+
+    if (packet::isQuote(packetSize)) {
+        Tick.lastTradedQuantity = read<int32_t>(packet::LAST_TRADED_QUANTITY);
+        Tick.averageTradePrice = priceAt(packet::AVERAGE_TRADE_PRICE);
+        Tick.volumeTraded = read<int32_t>(packet::VOLUME_TRADED);
+        Tick.totalBuyQuantity = read<int32_t>(packet::TOTAL_BUY_QUANTITY);
+        Tick.totalSellQuantity = read<int32_t>(packet::TOTAL_SELL_QUANTITY);
+
+        if (packet::isFull(packetSize)) {
+            Tick.lastTradeTime = read<int32_t>(packet::LAST_TRADE_TIME);
+            Tick.oi = read<int32_t>(packet::OI);
+            Tick.oiDayHigh = read<int32_t>(packet::OI_DAY_HIGH);
+            Tick.oiDayLow = read<int32_t>(packet::OI_DAY_LOW);
+
+            internal::depth::levels depthLevels;
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            internal::depth::decode(
+                bytes + packet::DEPTH, divisor, depthLevels);
+            const auto middle = depthLevels.begin() + kc::tick::DEPTH_LEVELS;
+            std::copy(
+                depthLevels.begin(), middle, Tick.marketDepth.buy.begin());
+            std::copy(
+                middle, depthLevels.end(), Tick.marketDepth.sell.begin());
+            Tick.marketDepth.count = kc::tick::DEPTH_LEVELS;
+        };
+    };
+    return Tick;
+}
+
+} // namespace kiteconnect
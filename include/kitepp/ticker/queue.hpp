@@ -0,0 +1,242 @@
+/*
+ *  Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+ *  SPDX-License-Identifier: MIT
+ *
+ *  Copyright (c) 2020-2022 Bhumit Attarde
+ *
+ *  Permission is hereby  granted, free of charge, to any  person obtaining a
+ * copy of this software and associated  documentation files (the "Software"),
+ * to deal in the Software  without restriction, including without  limitation
+ * the rights to  use, copy,  modify, merge,  publish, distribute,  sublicense,
+ * and/or  sell copies  of  the Software,  and  to  permit persons  to  whom the
+ * Software  is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS
+ * OR IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN
+ * NO EVENT  SHALL THE AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY
+ * CLAIM,  DAMAGES OR  OTHER LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT
+ * OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+#include "../responses/ws.hpp"
+#include "snapshot.hpp"
+
+namespace kiteconnect {
+
+namespace kc = kiteconnect;
+
+/// What a `tickQueue` does with a tick when it's full.
+enum class OVERFLOW_POLICY : uint8_t
+{
+    /// wait until the consumer makes room. Stalls `ticker`'s event loop.
+    BLOCK,
+    /// drop the oldest tick in the queue
+    DROP_OLDEST,
+    /// keep only the latest tick of every instrument, so the queue only
+    /// overflows if it has more instruments than its capacity
+    CONFLATE
+};
+
+///
+/// @brief Bounded lock-free queue that hands ticks from `ticker`'s event loop
+///        to a consumer thread.
+///
+/// A queue has a single producer (`ticker`) and a single consumer. Register it
+/// with `ticker::addTickQueue()` and drain it with `pop()` from the consumer
+/// thread, which keeps slow consumers from stalling socket reads and
+/// heartbeats.
+///
+class tickQueue {
+  public:
+    ///
+    /// @brief Construct a new queue.
+    ///
+    /// @param Capacity maximum number of queued ticks (instruments when
+    ///                 conflating), rounded up to a power of two
+    /// @param Policy   what is done with ticks when the queue is full
+    ///
+    explicit tickQueue(
+        size_t Capacity, OVERFLOW_POLICY Policy = OVERFLOW_POLICY::DROP_OLDEST);
+
+    ///
+    /// @brief Queue a tick. Must only be called by the producer.
+    ///
+    /// @return bool `false` if the tick was dropped
+    ///
+    bool push(const kc::tick& Tick);
+
+    ///
+    /// @brief Take the oldest tick from the queue. Must only be called by the
+    ///        consumer, never blocks.
+    ///
+    /// @return bool `false` if the queue is empty
+    ///
+    bool pop(kc::tick& Tick);
+
+    ///
+    /// @brief Make a blocked `push()` give up. Should be called when the
+    ///        consumer stops consuming a queue with the `BLOCK` policy.
+    ///
+    void close() { closed.store(true, std::memory_order_release); };
+
+    /// @brief Number of ticks waiting in the queue.
+    [[nodiscard]] size_t size() const {
+        // head is read first, tail can't be behind it
+        const uint64_t headIndex = head.load(std::memory_order_acquire);
+        return static_cast<size_t>(
+            tail.load(std::memory_order_acquire) - headIndex);
+    };
+
+    [[nodiscard]] size_t capacity() const { return mask + 1; };
+
+    [[nodiscard]] OVERFLOW_POLICY policy() const { return overflowPolicy; };
+
+    ///
+    /// @brief Number of ticks that were dropped, including ticks that were
+    ///        replaced by a newer tick of the same instrument when conflating.
+    ///
+    [[nodiscard]] uint64_t dropped() const {
+        return droppedTicks.load(std::memory_order_relaxed);
+    };
+
+  private:
+    static constexpr size_t CACHE_LINE = 64;
+
+    OVERFLOW_POLICY overflowPolicy;
+    size_t mask;
+    // BLOCK & DROP_OLDEST queue ticks. CONFLATE queues instrument tokens and
+    // keeps their latest ticks in a snapshot store.
+    std::unique_ptr<internal::atomicTick[]> ticks;
+    std::unique_ptr<std::atomic<int32_t>[]> tokens;
+    std::unique_ptr<kc::tickSnapshots> latest;
+    std::atomic<bool> closed { false };
+    std::atomic<uint64_t> droppedTicks { 0 };
+    // consumer's index. Also advanced by the producer when it drops the oldest
+    // tick, which is why it's only ever moved with a CAS.
+    alignas(CACHE_LINE) std::atomic<uint64_t> head { 0 };
+    // producer's index
+    alignas(CACHE_LINE) std::atomic<uint64_t> tail { 0 };
+
+    static size_t roundUp(size_t capacity) {
+        size_t size = 1;
+        while (size < capacity) { size <<= 1U; };
+        return size;
+    };
+
+    bool pushConflated(const kc::tick& Tick);
+
+    bool popConflated(kc::tick& Tick);
+};
+
+inline tickQueue::tickQueue(size_t Capacity, OVERFLOW_POLICY Policy)
+    : overflowPolicy(Policy), mask(roundUp(Capacity) - 1) {
+    if (overflowPolicy == OVERFLOW_POLICY::CONFLATE) {
+        tokens = std::make_unique<std::atomic<int32_t>[]>(mask + 1);
+        latest = std::make_unique<kc::tickSnapshots>(mask + 1);
+    } else {
+        ticks = std::make_unique<internal::atomicTick[]>(mask + 1);
+    };
+};
+
+// NOLINTBEGIN(cppcoreguidelines-pro-bounds-constant-array-index)
+inline bool tickQueue::push(const kc::tick& Tick) {
+    if (overflowPolicy == OVERFLOW_POLICY::CONFLATE) {
+        return pushConflated(Tick);
+    };
+
+    const uint64_t tailIndex = tail.load(std::memory_order_relaxed);
+    uint64_t headIndex = head.load(std::memory_order_acquire);
+    while (tailIndex - headIndex > mask) {
+        if (overflowPolicy == OVERFLOW_POLICY::BLOCK) {
+            if (closed.load(std::memory_order_acquire)) {
+                droppedTicks.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            };
+            std::this_thread::yield();
+            headIndex = head.load(std::memory_order_acquire);
+        } else if (head.compare_exchange_weak(headIndex, headIndex + 1,
+                       std::memory_order_acq_rel,
+                       std::memory_order_acquire)) {
+            droppedTicks.fetch_add(1, std::memory_order_relaxed);
+            headIndex++;
+        };
+    };
+    ticks[tailIndex & mask].store(Tick);
+    tail.store(tailIndex + 1, std::memory_order_release);
+    return true;
+};
+
+inline bool tickQueue::pop(kc::tick& Tick) {
+    if (overflowPolicy == OVERFLOW_POLICY::CONFLATE) {
+        return popConflated(Tick);
+    };
+
+    uint64_t headIndex = head.load(std::memory_order_acquire);
+    while (headIndex != tail.load(std::memory_order_acquire)) {
+        ticks[headIndex & mask].load(Tick);
+        // fails if the producer dropped the tick (and may have overwritten it)
+        // while it was being read
+        if (head.compare_exchange_weak(headIndex, headIndex + 1,
+                std::memory_order_acq_rel, std::memory_order_acquire)) {
+            return true;
+        };
+    };
+    return false;
+};
+
+inline bool tickQueue::pushConflated(const kc::tick& Tick) {
+    kc::tickSnapshots::slot* Slot = latest->insert(Tick.instrumentToken);
+    if (Slot == nullptr) {
+        droppedTicks.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    };
+    kc::tickSnapshots::write(*Slot, Tick);
+    // the instrument is already waiting, its queued tick was replaced
+    if (Slot->queued.exchange(true, std::memory_order_acq_rel)) {
+        droppedTicks.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    };
+
+    // every queued instrument has a slot, so this only happens if tokens that
+    // don't fit the table were pushed
+    const uint64_t tailIndex = tail.load(std::memory_order_relaxed);
+    if (tailIndex - head.load(std::memory_order_acquire) > mask) {
+        Slot->queued.store(false, std::memory_order_release);
+        droppedTicks.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    };
+    tokens[tailIndex & mask].store(
+        Tick.instrumentToken, std::memory_order_relaxed);
+    tail.store(tailIndex + 1, std::memory_order_release);
+    return true;
+};
+
+inline bool tickQueue::popConflated(kc::tick& Tick) {
+    const uint64_t headIndex = head.load(std::memory_order_relaxed);
+    if (headIndex == tail.load(std::memory_order_acquire)) { return false; };
+    const int32_t token =
+        tokens[headIndex & mask].load(std::memory_order_relaxed);
+    head.store(headIndex + 1, std::memory_order_release);
+
+    // unmarking before reading means a tick stored after this either is read
+    // now or queues the instrument again, it's never lost
+    const kc::tickSnapshots::slot* Slot = latest->find(token);
+    Slot->queued.exchange(false, std::memory_order_acq_rel);
+    return kc::tickSnapshots::read(*Slot, Tick);
+};
+// NOLINTEND(cppcoreguidelines-pro-bounds-constant-array-index)
+
+} // namespace kiteconnect
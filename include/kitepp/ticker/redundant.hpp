@@ -0,0 +1,409 @@
+/*
+ *  Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+ *  SPDX-License-Identifier: MIT
+ *
+ *  Copyright (c) 2020-2022 Bhumit Attarde
+ *
+ *  Permission is hereby  granted, free of charge, to any  person obtaining a
+ * copy of this software and associated  documentation files (the "Software"),
+ * to deal in the Software  without restriction, including without  limitation
+ * the rights to  use, copy,  modify, merge,  publish, distribute,  sublicense,
+ * and/or  sell copies  of  the Software,  and  to  permit persons  to  whom the
+ * Software  is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS
+ * OR IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN
+ * NO EVENT  SHALL THE AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY
+ * CLAIM,  DAMAGES OR  OTHER LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT
+ * OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../responses/responses.hpp"
+#include "../userconstants.hpp" //modes
+#include "ws.hpp"
+
+#include <uWS/uWS.h>
+
+namespace kiteconnect {
+
+using std::string;
+namespace kc = kiteconnect;
+
+///
+/// \brief \a redundantTicker keeps two subscribed `ticker` connections on a
+///         single event loop and delivers ticks of whichever is first.
+///
+/// Both connections subscribe to every instrument, so when one of them fails,
+/// the other is already delivering ticks and there's no gap while the failed
+/// one reconnects and subscribes again. A tick is delivered only if it's
+/// newer than the last delivered tick of its instrument, by exchange
+/// timestamp and then volume traded, so each one is delivered once however
+/// the connections interleave.
+///
+/// LTP mode packets and quote mode packets of indices have neither, so
+/// they're compared by last price and arrival order instead. Such a tick is
+/// delivered if it's received on the connection that delivered the
+/// instrument's last one, or if its price wasn't delivered in the last
+/// `LTP_WINDOW`. An echo that lags more than that is delivered again. Ticks
+/// that don't change the timestamp or volume of an instrument (e.g., quote
+/// mode ticks of a change in pending quantities) are dropped as duplicates.
+///
+/// Order updates are delivered from the primary connection only. The
+/// standby takes over the primary role as soon as the primary is closed.
+///
+class redundantTicker {
+
+  public:
+    /// Number of connections.
+    static constexpr size_t CONNECTIONS = 2;
+
+    /// How long a delivered LTP tick's price is matched against (ms).
+    static constexpr uint64_t LTP_WINDOW = 1000;
+
+    // callbacks
+    /// @brief Called when the first connection is connected.
+    std::function<void(redundantTicker* ws)> onConnect;
+
+    /// @brief Called when ticks are received on either connection, without
+    ///        duplicates. Should be set before `connect()`.
+    std::function<void(
+        redundantTicker* ws, const std::vector<kc::tick>& ticks)>
+        onTicks;
+
+    /// @brief Called when an order update is received on the primary
+    ///        connection.
+    std::function<void(redundantTicker* ws, const kc::postback& postback)>
+        onOrderUpdate;
+
+    ///
+    /// @brief Called when the primary connection is closed and the other one
+    ///        becomes the primary.
+    ///
+    /// @param primary index of the new primary connection
+    ///
+    std::function<void(redundantTicker* ws, size_t primary)> onFailover;
+
+    /// @brief Called when a connection is closed with an error or websocket
+    ///        server sends an error message.
+    std::function<void(
+        redundantTicker* ws, size_t index, int code, const string& message)>
+        onError;
+
+    /// @brief Called when a connection is closed.
+    std::function<void(
+        redundantTicker* ws, size_t index, int code, const string& message)>
+        onClose;
+
+    ///
+    /// \brief Construct a new redundant ticker. All durations are in seconds.
+    ///
+    /// \param Key               API key
+    /// \param ConnectTimeout    connection timeout
+    /// \param EnableReconnect   auto reconnect is enabled if
+    ///                          \a EnableReconnect is set to `true`
+    /// \param MaxReconnectDelay Maximum delay after which subsequent
+    ///                          reconnection interval will become constant
+    /// \param MaxReconnectTries Maximum number of retries before a connection
+    ///                          quits trying to reconnect.
+    ///
+    explicit redundantTicker(const string& Key,
+        unsigned int ConnectTimeout = ticker::DEFAULT_CONNECT_TIMEOUT,
+        bool EnableReconnect = true,
+        unsigned int MaxReconnectDelay = ticker::DEFAULT_MAX_RECONNECT_DELAY,
+        unsigned int MaxReconnectTries = ticker::DEFAULT_MAX_RECONNECT_TRIES);
+
+    ///
+    /// @brief Set the access token of both connections.
+    ///
+    /// @param token access token is set to \a token.
+    ///
+    void setAccessToken(const string& token);
+
+    /// @brief Connect both connections to the websocket server.
+    void connect();
+
+    /// @brief Check if any connection is connected.
+    [[nodiscard]] bool isConnected() const;
+
+    /// @brief Start the client. Should always be called after `connect()`.
+    void run();
+
+    /// @brief Stop the client. Closes both connections.
+    void stop();
+
+    ///
+    /// @brief Subscribe both connections to a list of instrument tokens.
+    ///        Instruments can be subscribed before connecting.
+    ///
+    /// @param instrumentTokens list of instrument tokens that should be
+    ///                         subscribed
+    ///
+    void subscribe(const std::vector<int>& instrumentTokens);
+
+    ///
+    /// @brief Unsubscribe.
+    ///
+    /// @param instrumentTokens list of instrument tokens that should be
+    ///                         unsubscribed
+    ///
+    void unsubscribe(const std::vector<int>& instrumentTokens);
+
+    ///
+    /// @brief Set the mode of instrument tokens on both connections.
+    ///
+    /// @param mode             mode to set
+    /// @param instrumentTokens list of instrument tokens whose mode should be
+    ///                         set
+    ///
+    void setMode(const string& mode, const std::vector<int>& instrumentTokens);
+
+    /// @brief Index of the connection order updates are delivered from.
+    [[nodiscard]] size_t primary() const { return primaryIndex; };
+
+    ///
+    /// @brief Get the number of ticks dropped because they had already been
+    ///        delivered from the other connection.
+    ///
+    /// @return uint64_t number of dropped ticks
+    ///
+    [[nodiscard]] uint64_t getDuplicateCount() const {
+        return duplicates.load(std::memory_order_relaxed);
+    };
+
+    ///
+    /// @brief Get a connection, e.g., to enable its watchdog. Its callbacks
+    ///        are owned by `redundantTicker`.
+    ///
+    kc::ticker& connection(size_t index) { return *connections.at(index); };
+
+  private:
+    friend class tickerTest_redundantTickerTest_Test;
+    // what a delivered tick of an instrument is compared by
+    struct tickKey {
+        int32_t timestamp = -1;
+        int32_t volumeTraded = -1;
+    };
+    // prices of the last ticks without a timestamp or volume delivered for
+    // an instrument, with their monotonic arrival times (ns)
+    static constexpr size_t RECENT_PRICES = 8;
+    struct recentPrices {
+        std::array<kc::Price, RECENT_PRICES> prices {};
+        std::array<uint64_t, RECENT_PRICES> times {};
+        size_t next = 0;
+        // connection the last one was received on
+        size_t index = 0;
+    };
+    // destroyed after the connections, whose groups belong to it
+    uWS::Hub hub;
+    std::array<std::unique_ptr<kc::ticker>, CONNECTIONS> connections;
+    size_t primaryIndex = 0;
+    bool connected = false;
+    std::unordered_map<int32_t, tickKey> lastDelivered;
+    std::unordered_map<int32_t, recentPrices> recentlyDelivered;
+    // ticks that weren't delivered before, reused between frames
+    std::vector<kc::tick> freshTicks;
+    std::atomic<uint64_t> duplicates { 0 };
+
+    void assignCallbacks(size_t index);
+
+    // records the tick if it's newer than the last delivered one, \a index
+    // is the connection it was received on at monotonic time \a now (ns)
+    bool isFresh(const kc::tick& Tick, size_t index, uint64_t now);
+
+    // isFresh() of ticks without a timestamp or volume
+    bool isFreshPrice(const kc::tick& Tick, size_t index, uint64_t now);
+
+    void deliver(const std::vector<kc::tick>& ticks, size_t index);
+};
+
+inline redundantTicker::redundantTicker(const string& Key,
+    unsigned int ConnectTimeout, bool EnableReconnect,
+    unsigned int MaxReconnectDelay, unsigned int MaxReconnectTries) {
+    for (auto& Connection : connections) {
+        // the constructor sharing a hub is private to ticker
+        // NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
+        Connection.reset(new kc::ticker(Key, &hub, ConnectTimeout,
+            EnableReconnect, MaxReconnectDelay, MaxReconnectTries));
+    };
+};
+
+inline void redundantTicker::setAccessToken(const string& token) {
+    for (auto& Connection : connections) { Connection->setAccessToken(token); };
+};
+
+inline void redundantTicker::connect() {
+    for (size_t i = 0; i < CONNECTIONS; i++) {
+        assignCallbacks(i);
+        connections[i]->connect();
+    };
+};
+
+inline bool redundantTicker::isConnected() const {
+    return connections[0]->isConnected() || connections[1]->isConnected();
+};
+
+inline void redundantTicker::run() { hub.run(); };
+
+inline void redundantTicker::stop() {
+    for (auto& Connection : connections) { Connection->stop(); };
+};
+
+inline void redundantTicker::subscribe(
+    const std::vector<int>& instrumentTokens) {
+    for (auto& Connection : connections) {
+        if (Connection->isConnected()) {
+            Connection->subscribe(instrumentTokens);
+            continue;
+        };
+        // subscribed once the connection connects
+        for (const int tok : instrumentTokens) {
+            Connection->subbedInstruments[tok] = Connection->DEFAULT_MODE;
+        };
+    };
+};
+
+inline void redundantTicker::unsubscribe(
+    const std::vector<int>& instrumentTokens) {
+    for (auto& Connection : connections) {
+        if (Connection->isConnected()) {
+            Connection->unsubscribe(instrumentTokens);
+            continue;
+        };
+        for (const int tok : instrumentTokens) {
+            Connection->subbedInstruments.erase(tok);
+        };
+    };
+    for (const int tok : instrumentTokens) {
+        lastDelivered.erase(tok);
+        recentlyDelivered.erase(tok);
+    };
+};
+
+inline void redundantTicker::setMode(
+    const string& mode, const std::vector<int>& instrumentTokens) {
+    const ticker::MODES parsed = ticker::parseMode(mode);
+    for (auto& Connection : connections) {
+        if (Connection->isConnected()) {
+            Connection->setMode(mode, instrumentTokens);
+            continue;
+        };
+        for (const int tok : instrumentTokens) {
+            Connection->subbedInstruments[tok] = parsed;
+        };
+    };
+    // ticks of another mode may not carry the fields ticks are compared by
+    for (const int tok : instrumentTokens) {
+        lastDelivered.erase(tok);
+        recentlyDelivered.erase(tok);
+    };
+};
+
+inline bool redundantTicker::isFresh(
+    const kc::tick& Tick, size_t index, uint64_t now) {
+    const tickKey key { Tick.timestamp, Tick.volumeTraded };
+    if (key.timestamp == -1 && key.volumeTraded == -1) {
+        return isFreshPrice(Tick, index, now);
+    };
+    auto [it, inserted] = lastDelivered.try_emplace(Tick.instrumentToken, key);
+    if (inserted) { return true; };
+
+    // both only grow during a session
+    tickKey& last = it->second;
+    const bool fresh = key.timestamp > last.timestamp ||
+                       (key.timestamp == last.timestamp &&
+                           key.volumeTraded > last.volumeTraded);
+    if (fresh) { last = key; };
+    return fresh;
+};
+
+inline bool redundantTicker::isFreshPrice(
+    const kc::tick& Tick, size_t index, uint64_t now) {
+    static constexpr uint64_t WINDOW = LTP_WINDOW * 1000000; // ns
+    auto [it, inserted] = recentlyDelivered.try_emplace(Tick.instrumentToken);
+    recentPrices& recent = it->second;
+    // a connection sends an instrument's ticks in order, so the one that's
+    // ahead only sends new ones, while the other echoes delivered prices
+    if (!inserted && index != recent.index) {
+        for (size_t i = 0; i < RECENT_PRICES; i++) {
+            if (recent.times[i] != 0 && now - recent.times[i] <= WINDOW &&
+                recent.prices[i] == Tick.lastPrice) {
+                return false;
+            };
+        };
+    };
+    recent.prices[recent.next] = Tick.lastPrice;
+    recent.times[recent.next] = now;
+    recent.next = (recent.next + 1) % RECENT_PRICES;
+    recent.index = index;
+    return true;
+};
+
+inline void redundantTicker::deliver(
+    const std::vector<kc::tick>& ticks, size_t index) {
+    const uint64_t now = kc::tickerStats::now();
+    freshTicks.clear();
+    for (const kc::tick& Tick : ticks) {
+        if (isFresh(Tick, index, now)) { freshTicks.push_back(Tick); };
+    };
+    duplicates.fetch_add(
+        ticks.size() - freshTicks.size(), std::memory_order_relaxed);
+    if (!freshTicks.empty()) { onTicks(this, freshTicks); };
+};
+
+inline void redundantTicker::assignCallbacks(size_t index) {
+    kc::ticker& Connection = *connections[index];
+    Connection.onConnect = [this, index](ticker* /*ws*/) {
+        // the first connection that's up serves as the primary
+        if (!connections[primaryIndex]->isConnected()) {
+            primaryIndex = index;
+        };
+        if (!connected) {
+            connected = true;
+            if (onConnect) { onConnect(this); };
+        };
+    };
+    if (onTicks) {
+        Connection.onTicks = [this, index](ticker* /*ws*/,
+                                 const std::vector<kc::tick>& ticks) {
+            deliver(ticks, index);
+        };
+    };
+    if (onOrderUpdate) {
+        Connection.onOrderUpdate = [this, index](ticker* /*ws*/,
+                                       const kc::postback& postback) {
+            if (index == primaryIndex) { onOrderUpdate(this, postback); };
+        };
+    };
+    Connection.onError = [this, index](
+                             ticker* /*ws*/, int code, const string& message) {
+        if (onError) { onError(this, index, code, message); };
+    };
+    Connection.onClose = [this, index](
+                             ticker* /*ws*/, int code, const string& message) {
+        if (index == primaryIndex) {
+            primaryIndex = (index + 1) % CONNECTIONS;
+            if (onFailover) { onFailover(this, primaryIndex); };
+        };
+        connected = isConnected();
+        if (onClose) { onClose(this, index, code, message); };
+    };
+};
+
+} // namespace kiteconnect
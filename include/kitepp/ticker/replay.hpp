@@ -0,0 +1,234 @@
+/*
+ *  Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+ *  SPDX-License-Identifier: MIT
+ *
+ *  Copyright (c) 2020-2022 Bhumit Attarde
+ *
+ *  Permission is hereby  granted, free of charge, to any  person obtaining a
+ * copy of this software and associated  documentation files (the "Software"),
+ * to deal in the Software  without restriction, including without  limitation
+ * the rights to  use, copy,  modify, merge,  publish, distribute,  sublicense,
+ * and/or  sell copies  of  the Software,  and  to  permit persons  to  whom the
+ * Software  is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS
+ * OR IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN
+ * NO EVENT  SHALL THE AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY
+ * CLAIM,  DAMAGES OR  OTHER LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT
+ * OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../exceptions.hpp"
+#include "../utils.hpp"
+#include "journal.hpp"
+#include "ws.hpp"
+
+#include <uWS/uWS.h>
+
+namespace kiteconnect {
+
+using std::string;
+namespace kc = kiteconnect;
+
+///
+/// \brief \a tickReplay feeds recorded frames to a `ticker` without a
+///         connection.
+///
+/// Frames are processed exactly like frames received by the websocket, so
+/// `onTicks`, `onOrderUpdate` and every other consumer of the ticker is called
+/// as usual. Frames can be replayed with their recorded timing, sped up or as
+/// fast as possible, which makes a replay double as a parser benchmark.
+///
+class tickReplay {
+  public:
+    /// Speed at which frames are replayed without waiting between them.
+    static constexpr double MAX_SPEED = 0;
+
+    /// Throughput of a replay.
+    struct stats {
+        uint64_t frames = 0;
+        uint64_t ticks = 0;
+        std::chrono::nanoseconds elapsed { 0 };
+
+        [[nodiscard]] double framesPerSecond() const {
+            return perSecond(frames);
+        };
+
+        [[nodiscard]] double ticksPerSecond() const {
+            return perSecond(ticks);
+        };
+
+      private:
+        [[nodiscard]] double perSecond(uint64_t count) const {
+            const std::chrono::duration<double> seconds = elapsed;
+            return (seconds.count() > 0)
+                       ? static_cast<double>(count) / seconds.count()
+                       : 0;
+        };
+    };
+
+    ///
+    /// @brief Construct a new replay.
+    ///
+    /// @param Ticker ticker frames are fed to, doesn't have to be connected
+    ///
+    explicit tickReplay(ticker& Ticker);
+
+    ///
+    /// @brief Add a frame to the end of the replay.
+    ///
+    /// @param opCode      websocket opcode of the frame
+    /// @param data        frame payload
+    /// @param length      length of \a data
+    /// @param receiveTime time the frame was received at (ns), `0` if it isn't
+    ///                    known. Frames without one are never waited for.
+    ///
+    void addFrame(uint8_t opCode, const char* data, size_t length,
+        uint64_t receiveTime = 0);
+
+    ///
+    /// @brief Add a file holding a single binary frame, like
+    ///        `tests/mock_custom/websocket_ticks.bin`.
+    ///
+    /// @param path path of the file
+    ///
+    /// @throw libException if the file can't be read
+    ///
+    void loadFrame(const string& path);
+
+#ifndef KITE_DISABLE_JOURNAL
+    ///
+    /// @brief Add every frame of a journal written by `tickJournal`.
+    ///
+    /// @param prefix path prefix the journal was created with
+    ///
+    /// @return uint64_t number of frames added
+    ///
+    uint64_t loadJournal(const string& prefix);
+#endif
+
+    ///
+    /// @brief Feed every frame to the ticker, on the calling thread.
+    ///
+    /// @param speed  multiple of the recorded speed frames are replayed at,
+    ///               `1` for real time and `MAX_SPEED` to not wait at all
+    /// @param repeat number of times the frames are replayed
+    ///
+    /// @return stats throughput of the replay
+    ///
+    stats run(double speed = MAX_SPEED, size_t repeat = 1);
+
+    /// @brief Get the number of frames in the replay.
+    [[nodiscard]] size_t frameCount() const;
+
+    /// @brief Remove every frame.
+    void clear();
+
+  private:
+    struct frame {
+        uint8_t opCode;
+        uint64_t receiveTime;
+        size_t offset;
+        size_t length;
+    };
+
+    ticker& target;
+    std::vector<frame> frames;
+    // payloads of all frames, back to back
+    std::vector<char> payloads;
+    // frames are copied before they're processed since processing may modify
+    // them
+    std::vector<char> scratch;
+};
+
+inline tickReplay::tickReplay(ticker& Ticker): target(Ticker) {};
+
+inline void tickReplay::addFrame(
+    uint8_t opCode, const char* data, size_t length, uint64_t receiveTime) {
+    frames.push_back({ opCode, receiveTime, payloads.size(), length });
+    payloads.insert(payloads.end(), data, std::next(data, length));
+};
+
+inline void tickReplay::loadFrame(const string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) { throw libException(FMT("failed to open {0}", path)); };
+    const std::vector<char> data((std::istreambuf_iterator<char>(file)),
+        std::istreambuf_iterator<char>());
+    addFrame(static_cast<uint8_t>(uWS::OpCode::BINARY), data.data(),
+        data.size());
+};
+
+#ifndef KITE_DISABLE_JOURNAL
+inline uint64_t tickReplay::loadJournal(const string& prefix) {
+    const size_t before = frames.size();
+    kc::tickJournal::read(prefix,
+        [&](const kc::tickJournal::recordHeader& header, const char* payload) {
+            addFrame(header.opCode, payload, header.length, header.receiveTime);
+        });
+    return frames.size() - before;
+};
+#endif
+
+inline tickReplay::stats tickReplay::run(double speed, size_t repeat) {
+    using clock = std::chrono::steady_clock;
+    stats result;
+    const clock::time_point start = clock::now();
+
+    for (size_t pass = 0; pass < repeat; pass++) {
+        const clock::time_point passStart = clock::now();
+        uint64_t firstReceiveTime = 0;
+        for (const frame& Frame : frames) {
+            if (speed > MAX_SPEED && Frame.receiveTime != 0) {
+                if (firstReceiveTime == 0) {
+                    firstReceiveTime = Frame.receiveTime;
+                };
+                const std::chrono::duration<double, std::nano> offset(
+                    static_cast<double>(Frame.receiveTime - firstReceiveTime) /
+                    speed);
+                std::this_thread::sleep_until(
+                    passStart +
+                    std::chrono::duration_cast<clock::duration>(offset));
+            };
+
+            scratch.assign(std::next(payloads.begin(),
+                               static_cast<ptrdiff_t>(Frame.offset)),
+                std::next(payloads.begin(),
+                    static_cast<ptrdiff_t>(Frame.offset + Frame.length)));
+            const auto opCode = static_cast<uWS::OpCode>(Frame.opCode);
+            if (opCode == uWS::OpCode::BINARY && scratch.size() > 1) {
+                result.ticks += ticker::unpack<uint16_t>(scratch.data(), 0);
+            };
+            target.processMessage(scratch.data(), scratch.size(), opCode);
+            result.frames++;
+        };
+    };
+
+    result.elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        clock::now() - start);
+    return result;
+};
+
+inline size_t tickReplay::frameCount() const { return frames.size(); };
+
+inline void tickReplay::clear() {
+    frames.clear();
+    payloads.clear();
+};
+
+} // namespace kiteconnect
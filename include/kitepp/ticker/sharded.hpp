@@ -0,0 +1,416 @@
+/*
+ *  Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+ *  SPDX-License-Identifier: MIT
+ *
+ *  Copyright (c) 2020-2022 Bhumit Attarde
+ *
+ *  Permission is hereby  granted, free of charge, to any  person obtaining a
+ * copy of this software and associated  documentation files (the "Software"),
+ * to deal in the Software  without restriction, including without  limitation
+ * the rights to  use, copy,  modify, merge,  publish, distribute,  sublicense,
+ * and/or  sell copies  of  the Software,  and  to  permit persons  to  whom the
+ * Software  is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS
+ * OR IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN
+ * NO EVENT  SHALL THE AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY
+ * CLAIM,  DAMAGES OR  OTHER LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT
+ * OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../exceptions.hpp"
+#include "../responses/responses.hpp"
+#include "../userconstants.hpp" //modes
+#include "ws.hpp"
+
+#include <uWS/uWS.h>
+
+namespace kiteconnect {
+
+using std::string;
+namespace kc = kiteconnect;
+
+///
+/// \brief \a shardedTicker spreads subscriptions over multiple `ticker`
+///         connections that share a single event loop.
+///
+/// A connection can subscribe to at most `MAX_INSTRUMENTS_PER_SHARD`
+/// instruments. Instruments are assigned to the least loaded connection
+/// (shard) and moved between shards when unsubscribing leaves them uneven.
+/// Ticks of all shards are delivered to a single `onTicks`.
+///
+class shardedTicker {
+
+  public:
+    /// Maximum number of instruments a single connection can subscribe to.
+    static constexpr size_t MAX_INSTRUMENTS_PER_SHARD = 3000;
+
+    /// Difference in instruments between the most & least loaded shards after
+    /// which instruments are moved between them.
+    static constexpr size_t REBALANCE_THRESHOLD = 300;
+
+    // callbacks
+    /// @brief Called when all shards are connected.
+    std::function<void(shardedTicker* ws)> onConnect;
+
+    /// @brief Called when ticks are received on any of the shards. Should be
+    ///        set before `connect()`.
+    std::function<void(shardedTicker* ws, const std::vector<kc::tick>& ticks)>
+        onTicks;
+
+    ///
+    /// @brief Called when an order update is received. Every connection
+    ///        receives order updates, only the first shard's are delivered.
+    ///
+    std::function<void(shardedTicker* ws, const kc::postback& postback)>
+        onOrderUpdate;
+
+    /// @brief Called when an order update is received, without copying it.
+    ///        See `ticker::onOrderUpdateView`.
+    std::function<void(shardedTicker* ws, const kc::postbackView& postback)>
+        onOrderUpdateView;
+
+    /// @brief Called when a shard's connection is closed with an error or
+    ///        websocket server sends an error message.
+    std::function<void(
+        shardedTicker* ws, size_t shard, int code, const string& message)>
+        onError;
+
+    /// @brief Called when a shard's connection is closed.
+    std::function<void(
+        shardedTicker* ws, size_t shard, int code, const string& message)>
+        onClose;
+
+    ///
+    /// \brief Construct a new sharded ticker. All durations are in seconds.
+    ///
+    /// \param Key               API key
+    /// \param Shards            number of connections to open
+    /// \param ConnectTimeout    connection timeout
+    /// \param EnableReconnect   auto reconnect is enabled if
+    ///                          \a EnableReconnect is set to `true`
+    /// \param MaxReconnectDelay Maximum delay after which subsequent
+    ///                          reconnection interval will become constant
+    /// \param MaxReconnectTries Maximum number of retries before a shard quits
+    ///                          trying to reconnect.
+    ///
+    shardedTicker(const string& Key, size_t Shards,
+        unsigned int ConnectTimeout = ticker::DEFAULT_CONNECT_TIMEOUT,
+        bool EnableReconnect = false,
+        unsigned int MaxReconnectDelay = ticker::DEFAULT_MAX_RECONNECT_DELAY,
+        unsigned int MaxReconnectTries = ticker::DEFAULT_MAX_RECONNECT_TRIES);
+
+    ///
+    /// @brief Set the access token of all shards.
+    ///
+    /// @param token access token is set to \a token.
+    ///
+    void setAccessToken(const string& token);
+
+    /// @brief Connect all shards to the websocket server.
+    void connect();
+
+    /// @brief Check if all shards are connected.
+    [[nodiscard]] bool isConnected() const;
+
+    /// @brief Start the client. Should always be called after `connect()`.
+    void run();
+
+    /// @brief Stop the client. Closes all connections.
+    void stop();
+
+    ///
+    /// @brief Subscribe to a list of instrument tokens. Instruments can be
+    ///        subscribed before shards are connected.
+    ///
+    /// @param instrumentTokens list of instrument tokens that should be
+    ///                         subscribed
+    ///
+    /// @throws kc::libException if the instruments don't fit in the shards
+    ///
+    void subscribe(const std::vector<int>& instrumentTokens);
+
+    ///
+    /// @brief Unsubscribe. Rebalances shards if they're left uneven.
+    ///
+    /// @param instrumentTokens list of instrument tokens that should be
+    ///                         unsubscribed
+    ///
+    void unsubscribe(const std::vector<int>& instrumentTokens);
+
+    ///
+    /// @brief Set the mode of instrument tokens, subscribing the ones that
+    ///        aren't subscribed.
+    ///
+    /// @param mode             mode to set
+    /// @param instrumentTokens list of instrument tokens whose mode should be
+    ///                         set
+    ///
+    void setMode(const string& mode, const std::vector<int>& instrumentTokens);
+
+    /// @brief Number of shards.
+    [[nodiscard]] size_t shardCount() const { return shards.size(); };
+
+    /// @brief Number of instruments subscribed on a shard.
+    [[nodiscard]] size_t instrumentCount(size_t shard) const {
+        return shards.at(shard)->subbedInstruments.size();
+    };
+
+    /// @brief Shard an instrument is subscribed on, if it's subscribed.
+    [[nodiscard]] std::optional<size_t> shardOf(int instrumentToken) const;
+
+    ///
+    /// @brief Get a shard, e.g., to enable snapshots or tick queues on it.
+    ///        Its callbacks are owned by `shardedTicker`.
+    ///
+    kc::ticker& shard(size_t index) { return *shards.at(index); };
+
+  private:
+    friend class tickerTest_shardedTickerTest_Test;
+    // destroyed after the shards, whose groups belong to it
+    uWS::Hub hub;
+    std::vector<std::unique_ptr<kc::ticker>> shards;
+    std::unordered_map<int, size_t> instrumentShards;
+    size_t connectedShards = 0;
+
+    void assignCallbacks(size_t index);
+
+    // instruments that aren't assigned to a shard are assigned to the least
+    // loaded ones
+    std::unordered_map<size_t, std::vector<int>> assign(
+        const std::vector<int>& instrumentTokens);
+
+    void subscribeOn(size_t index, const std::vector<int>& instrumentTokens);
+
+    void unsubscribeOn(size_t index, const std::vector<int>& instrumentTokens);
+
+    void setModeOn(size_t index, ticker::MODES mode,
+        const std::vector<int>& instrumentTokens);
+
+    void rebalance();
+};
+
+inline shardedTicker::shardedTicker(const string& Key, size_t Shards,
+    unsigned int ConnectTimeout, bool EnableReconnect,
+    unsigned int MaxReconnectDelay, unsigned int MaxReconnectTries) {
+    if (Shards == 0) {
+        throw kc::libException("at least one shard is needed");
+    };
+    shards.reserve(Shards);
+    for (size_t i = 0; i < Shards; i++) {
+        // the constructor sharing a hub is private to ticker
+        // NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
+        shards.emplace_back(new kc::ticker(Key, &hub, ConnectTimeout,
+            EnableReconnect, MaxReconnectDelay, MaxReconnectTries));
+    };
+};
+
+inline void shardedTicker::setAccessToken(const string& token) {
+    for (auto& Shard : shards) { Shard->setAccessToken(token); };
+};
+
+inline void shardedTicker::connect() {
+    for (size_t i = 0; i < shards.size(); i++) {
+        assignCallbacks(i);
+        shards[i]->connect();
+    };
+};
+
+inline bool shardedTicker::isConnected() const {
+    return std::all_of(shards.begin(), shards.end(),
+        [](const auto& Shard) { return Shard->isConnected(); });
+};
+
+inline void shardedTicker::run() { hub.run(); };
+
+inline void shardedTicker::stop() {
+    for (auto& Shard : shards) { Shard->stop(); };
+};
+
+inline void shardedTicker::subscribe(const std::vector<int>& instrumentTokens) {
+    for (const auto& [index, tokens] : assign(instrumentTokens)) {
+        subscribeOn(index, tokens);
+    };
+};
+
+inline void shardedTicker::unsubscribe(
+    const std::vector<int>& instrumentTokens) {
+    std::unordered_map<size_t, std::vector<int>> byShard;
+    for (const int tok : instrumentTokens) {
+        auto it = instrumentShards.find(tok);
+        if (it == instrumentShards.end()) { continue; };
+        byShard[it->second].push_back(tok);
+        instrumentShards.erase(it);
+    };
+    for (const auto& [index, tokens] : byShard) {
+        unsubscribeOn(index, tokens);
+    };
+    rebalance();
+};
+
+inline void shardedTicker::setMode(
+    const string& mode, const std::vector<int>& instrumentTokens) {
+    const ticker::MODES parsed = ticker::parseMode(mode);
+    for (const auto& [index, tokens] : assign(instrumentTokens)) {
+        setModeOn(index, parsed, tokens);
+    };
+};
+
+inline std::optional<size_t> shardedTicker::shardOf(int instrumentToken) const {
+    auto it = instrumentShards.find(instrumentToken);
+    if (it == instrumentShards.end()) { return std::nullopt; };
+    return it->second;
+};
+
+inline std::unordered_map<size_t, std::vector<int>> shardedTicker::assign(
+    const std::vector<int>& instrumentTokens) {
+    std::vector<size_t> load(shards.size());
+    size_t free = 0;
+    for (size_t i = 0; i < shards.size(); i++) {
+        load[i] = instrumentCount(i);
+        free += MAX_INSTRUMENTS_PER_SHARD - std::min(load[i],
+                                                MAX_INSTRUMENTS_PER_SHARD);
+    };
+    size_t unassigned = 0;
+    for (const int tok : instrumentTokens) {
+        if (instrumentShards.count(tok) == 0) { unassigned++; };
+    };
+    // checked upfront so that nothing is subscribed if it won't all fit
+    if (unassigned > free) {
+        throw kc::libException(
+            FMT("cannot subscribe {0} more instruments, shards have room for "
+                "{1}",
+                unassigned, free));
+    };
+
+    std::unordered_map<size_t, std::vector<int>> byShard;
+    for (const int tok : instrumentTokens) {
+        auto it = instrumentShards.find(tok);
+        if (it == instrumentShards.end()) {
+            const size_t index = static_cast<size_t>(
+                std::min_element(load.begin(), load.end()) - load.begin());
+            load[index]++;
+            it = instrumentShards.emplace(tok, index).first;
+        };
+        byShard[it->second].push_back(tok);
+    };
+    return byShard;
+};
+
+inline void shardedTicker::subscribeOn(
+    size_t index, const std::vector<int>& instrumentTokens) {
+    kc::ticker& Shard = *shards[index];
+    if (Shard.isConnected()) {
+        Shard.subscribe(instrumentTokens);
+        return;
+    };
+    // subscribed once the shard connects
+    for (const int tok : instrumentTokens) {
+        Shard.subbedInstruments[tok] = Shard.DEFAULT_MODE;
+    };
+};
+
+inline void shardedTicker::unsubscribeOn(
+    size_t index, const std::vector<int>& instrumentTokens) {
+    kc::ticker& Shard = *shards[index];
+    if (Shard.isConnected()) {
+        Shard.unsubscribe(instrumentTokens);
+        return;
+    };
+    for (const int tok : instrumentTokens) {
+        Shard.subbedInstruments.erase(tok);
+    };
+};
+
+inline void shardedTicker::setModeOn(size_t index, ticker::MODES mode,
+    const std::vector<int>& instrumentTokens) {
+    kc::ticker& Shard = *shards[index];
+    if (Shard.isConnected()) {
+        Shard.setMode(ticker::modeName(mode), instrumentTokens);
+        return;
+    };
+    for (const int tok : instrumentTokens) {
+        Shard.subbedInstruments[tok] = mode;
+    };
+};
+
+inline void shardedTicker::rebalance() {
+    // every pass halves the gap between the most & least loaded shards
+    for (size_t pass = 0; pass < shards.size(); pass++) {
+        size_t most = 0;
+        size_t least = 0;
+        for (size_t i = 1; i < shards.size(); i++) {
+            if (instrumentCount(i) > instrumentCount(most)) { most = i; };
+            if (instrumentCount(i) < instrumentCount(least)) { least = i; };
+        };
+        const size_t gap = instrumentCount(most) - instrumentCount(least);
+        if (gap <= REBALANCE_THRESHOLD) { return; };
+
+        std::unordered_map<ticker::MODES, std::vector<int>> moved;
+        std::vector<int> tokens;
+        for (const auto& [tok, mode] : shards[most]->subbedInstruments) {
+            if (tokens.size() == gap / 2) { break; };
+            tokens.push_back(tok);
+            moved[mode].push_back(tok);
+        };
+        unsubscribeOn(most, tokens);
+        subscribeOn(least, tokens);
+        for (const auto& [mode, modeTokens] : moved) {
+            setModeOn(least, mode, modeTokens);
+        };
+        for (const int tok : tokens) { instrumentShards[tok] = least; };
+    };
+};
+
+inline void shardedTicker::assignCallbacks(size_t index) {
+    kc::ticker& Shard = *shards[index];
+    Shard.onConnect = [this](ticker* /*ws*/) {
+        connectedShards++;
+        if (connectedShards == shards.size() && onConnect) { onConnect(this); };
+    };
+    if (onTicks) {
+        Shard.onTicks = [this](ticker* /*ws*/,
+                            const std::vector<kc::tick>& ticks) {
+            onTicks(this, ticks);
+        };
+    };
+    if (index == 0 && onOrderUpdate) {
+        Shard.onOrderUpdate = [this](ticker* /*ws*/,
+                                  const kc::postback& postback) {
+            onOrderUpdate(this, postback);
+        };
+    };
+    if (index == 0 && onOrderUpdateView) {
+        Shard.onOrderUpdateView = [this](ticker* /*ws*/,
+                                      const kc::postbackView& postback) {
+            onOrderUpdateView(this, postback);
+        };
+    };
+    Shard.onError = [this, index](
+                        ticker* /*ws*/, int code, const string& message) {
+        if (onError) { onError(this, index, code, message); };
+    };
+    Shard.onClose = [this, index](
+                        ticker* /*ws*/, int code, const string& message) {
+        if (connectedShards > 0) { connectedShards--; };
+        if (onClose) { onClose(this, index, code, message); };
+    };
+};
+
+} // namespace kiteconnect
@@ -0,0 +1,250 @@
+/*
+ *  Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+ *  SPDX-License-Identifier: MIT
+ *
+ *  Copyright (c) 2020-2022 Bhumit Attarde
+ *
+ *  Permission is hereby  granted, free of charge, to any  person obtaining a
+ * copy of this software and associated  documentation files (the "Software"),
+ * to deal in the Software  without restriction, including without  limitation
+ * the rights to  use, copy,  modify, merge,  publish, distribute,  sublicense,
+ * and/or  sell copies  of  the Software,  and  to  permit persons  to  whom the
+ * Software  is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS
+ * OR IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN
+ * NO EVENT  SHALL THE AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY
+ * CLAIM,  DAMAGES OR  OTHER LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT
+ * OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <thread>
+
+#include "../responses/ws.hpp"
+
+namespace kiteconnect {
+
+namespace kc = kiteconnect;
+
+namespace internal {
+
+///
+/// @brief Tick stored as atomic words.
+///
+/// Lets a tick be read while it's being written without a data race. Readers
+/// have to detect torn reads themselves (e.g., with a sequence number).
+///
+class atomicTick {
+  public:
+    void store(const kc::tick& Tick) {
+        std::array<uint64_t, WORDS> buffer {};
+        std::memcpy(buffer.data(), &Tick, sizeof(kc::tick));
+        for (size_t i = 0; i < WORDS; i++) {
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+            words[i].store(buffer[i], std::memory_order_relaxed);
+        };
+    };
+
+    void load(kc::tick& Tick) const {
+        std::array<uint64_t, WORDS> buffer {};
+        for (size_t i = 0; i < WORDS; i++) {
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+            buffer[i] = words[i].load(std::memory_order_relaxed);
+        };
+        std::memcpy(
+            static_cast<void*>(&Tick), buffer.data(), sizeof(kc::tick));
+    };
+
+  private:
+    static constexpr size_t WORDS =
+        (sizeof(kc::tick) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+    std::array<std::atomic<uint64_t>, WORDS> words {};
+};
+
+} // namespace internal
+
+class tickQueue;
+
+///
+/// @brief Latest tick of every instrument, readable from any thread.
+///
+/// Instrument tokens are mapped to a fixed number of slots by an open
+/// addressing table. Every slot holds its instrument's last tick under a
+/// seqlock, so readers never lock or allocate and always get a tick that was
+/// stored as a whole. Ticks must only be stored by a single thread (`ticker`'s
+/// event loop).
+///
+class tickSnapshots {
+  public:
+    ///
+    /// @brief Construct a new store.
+    ///
+    /// @param Capacity maximum number of instruments that can be stored
+    ///
+    explicit tickSnapshots(size_t Capacity)
+        : maxInstruments(Capacity), mask(tableSize(Capacity) - 1),
+          slots(std::make_unique<slot[]>(mask + 1)) {};
+
+    ///
+    /// @brief Store a tick, replacing the last tick of its instrument. Must
+    ///        only be called from a single thread.
+    ///
+    /// @return bool `false` if the store is full and the tick is of an
+    ///              instrument that wasn't stored before
+    ///
+    bool store(const kc::tick& Tick);
+
+    ///
+    /// @brief Get the last tick of an instrument. Can be called from any
+    ///        thread.
+    ///
+    /// @param instrumentToken instrument token of the instrument
+    /// @param Tick            set to the last tick of the instrument
+    ///
+    /// @return bool `false` if no tick was stored for the instrument
+    ///
+    bool load(int32_t instrumentToken, kc::tick& Tick) const;
+
+    /// @brief Number of instruments that have been stored.
+    [[nodiscard]] size_t size() const {
+        return instruments.load(std::memory_order_relaxed);
+    };
+
+    /// @brief Maximum number of instruments that can be stored.
+    [[nodiscard]] size_t capacity() const { return maxInstruments; };
+
+  private:
+    friend class tickQueue;
+    static constexpr int32_t EMPTY = -1;
+    static constexpr size_t CACHE_LINE = 64;
+
+    struct alignas(CACHE_LINE) slot {
+        std::atomic<int32_t> token { EMPTY };
+        // odd while the tick is being written, 0 until the first write
+        std::atomic<uint32_t> sequence { 0 };
+        // set while the instrument is waiting in a conflating `tickQueue`,
+        // which clears it through a const slot
+        mutable std::atomic<bool> queued { false };
+        internal::atomicTick tick;
+    };
+
+    size_t maxInstruments;
+    size_t mask;
+    std::unique_ptr<slot[]> slots;
+    std::atomic<size_t> instruments { 0 };
+
+    // keeps the table at most half full, which keeps probe sequences short
+    static size_t tableSize(size_t capacity) {
+        size_t size = 1;
+        while (size < capacity * 2) { size <<= 1U; };
+        return size;
+    };
+
+    [[nodiscard]] size_t home(int32_t instrumentToken) const {
+        // fibonacci hashing, tokens of a segment only differ in upper bytes
+        // NOLINTNEXTLINE(cppcoreguidelines-avoid-magic-numbers)
+        constexpr uint64_t MULTIPLIER = 11400714819323198485ULL;
+        return static_cast<size_t>(
+                   (static_cast<uint64_t>(instrumentToken) * MULTIPLIER) >>
+                   32U) &
+               mask;
+    };
+
+    // slot of an instrument, claimed if the instrument is new. Only called by
+    // the writer.
+    slot* insert(int32_t instrumentToken);
+
+    [[nodiscard]] const slot* find(int32_t instrumentToken) const;
+
+    static void write(slot& Slot, const kc::tick& Tick);
+
+    static bool read(const slot& Slot, kc::tick& Tick);
+};
+
+// NOLINTBEGIN(cppcoreguidelines-pro-bounds-constant-array-index)
+inline tickSnapshots::slot* tickSnapshots::insert(int32_t instrumentToken) {
+    if (instrumentToken == EMPTY) { return nullptr; };
+
+    for (size_t i = 0, index = home(instrumentToken); i <= mask;
+         i++, index = (index + 1) & mask) {
+        slot& candidate = slots[index];
+        const int32_t token = candidate.token.load(std::memory_order_relaxed);
+        if (token == instrumentToken) { return &candidate; };
+        if (token == EMPTY) {
+            if (instruments.load(std::memory_order_relaxed) >= maxInstruments) {
+                return nullptr;
+            };
+            // readers ignore the slot until its sequence is past 0
+            candidate.token.store(instrumentToken, std::memory_order_release);
+            instruments.fetch_add(1, std::memory_order_relaxed);
+            return &candidate;
+        };
+    };
+    return nullptr;
+};
+
+inline const tickSnapshots::slot* tickSnapshots::find(
+    int32_t instrumentToken) const {
+    if (instrumentToken == EMPTY) { return nullptr; };
+
+    for (size_t i = 0, index = home(instrumentToken); i <= mask;
+         i++, index = (index + 1) & mask) {
+        const slot& candidate = slots[index];
+        const int32_t token = candidate.token.load(std::memory_order_acquire);
+        if (token == instrumentToken) { return &candidate; };
+        if (token == EMPTY) { return nullptr; };
+    };
+    return nullptr;
+};
+// NOLINTEND(cppcoreguidelines-pro-bounds-constant-array-index)
+
+inline void tickSnapshots::write(slot& Slot, const kc::tick& Tick) {
+    const uint32_t sequence = Slot.sequence.load(std::memory_order_relaxed);
+    Slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    Slot.tick.store(Tick);
+    Slot.sequence.store(sequence + 2, std::memory_order_release);
+};
+
+inline bool tickSnapshots::read(const slot& Slot, kc::tick& Tick) {
+    while (true) {
+        const uint32_t before = Slot.sequence.load(std::memory_order_acquire);
+        if (before == 0) { return false; };
+        if ((before & 1U) != 0) {
+            std::this_thread::yield();
+            continue;
+        };
+        Slot.tick.load(Tick);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (Slot.sequence.load(std::memory_order_relaxed) == before) {
+            return true;
+        };
+    };
+};
+
+inline bool tickSnapshots::store(const kc::tick& Tick) {
+    slot* Slot = insert(Tick.instrumentToken);
+    if (Slot == nullptr) { return false; };
+    write(*Slot, Tick);
+    return true;
+};
+
+inline bool tickSnapshots::load(int32_t instrumentToken, kc::tick& Tick) const {
+    const slot* Slot = find(instrumentToken);
+    return Slot != nullptr && read(*Slot, Tick);
+};
+
+} // namespace kiteconnect
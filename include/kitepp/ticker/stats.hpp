@@ -0,0 +1,216 @@
+/*
+ *  Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+ *  SPDX-License-Identifier: MIT
+ *
+ *  Copyright (c) 2020-2022 Bhumit Attarde
+ *
+ *  Permission is hereby  granted, free of charge, to any  person obtaining a
+ * copy of this software and associated  documentation files (the "Software"),
+ * to deal in the Software  without restriction, including without  limitation
+ * the rights to  use, copy,  modify, merge,  publish, distribute,  sublicense,
+ * and/or  sell copies  of  the Software,  and  to  permit persons  to  whom the
+ * Software  is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS
+ * OR IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN
+ * NO EVENT  SHALL THE AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY
+ * CLAIM,  DAMAGES OR  OTHER LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT
+ * OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace kiteconnect {
+
+namespace kc = kiteconnect;
+
+///
+/// @brief Histogram of non-negative integer values with a bounded relative
+///        error, in the style of HdrHistogram.
+///
+/// Values below `2^SUB_BUCKET_BITS` are counted exactly, larger ones in
+/// buckets no wider than `1 / 2^SUB_BUCKET_BITS` of their value (6.25%).
+/// Recording is lock-free and can be done from multiple threads while others
+/// read the histogram.
+///
+class latencyHistogram {
+  public:
+    static constexpr unsigned int SUB_BUCKET_BITS = 4;
+
+    void record(uint64_t value) {
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+        counts[bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+        total.fetch_add(1, std::memory_order_relaxed);
+        sum.fetch_add(value, std::memory_order_relaxed);
+        uint64_t current = minimum.load(std::memory_order_relaxed);
+        while (value < current &&
+               !minimum.compare_exchange_weak(
+                   current, value, std::memory_order_relaxed)) {};
+        current = maximum.load(std::memory_order_relaxed);
+        while (value > current &&
+               !maximum.compare_exchange_weak(
+                   current, value, std::memory_order_relaxed)) {};
+    };
+
+    /// @brief Get the number of recorded values.
+    [[nodiscard]] uint64_t count() const {
+        return total.load(std::memory_order_relaxed);
+    };
+
+    /// @brief Get the smallest recorded value, `0` if there are none.
+    [[nodiscard]] uint64_t min() const {
+        return (count() == 0) ? 0 : minimum.load(std::memory_order_relaxed);
+    };
+
+    /// @brief Get the largest recorded value.
+    [[nodiscard]] uint64_t max() const {
+        return maximum.load(std::memory_order_relaxed);
+    };
+
+    /// @brief Get the mean of the recorded values.
+    [[nodiscard]] double mean() const {
+        const uint64_t n = count();
+        return (n == 0) ? 0
+                        : static_cast<double>(
+                              sum.load(std::memory_order_relaxed)) /
+                              static_cast<double>(n);
+    };
+
+    ///
+    /// @brief Get a percentile of the recorded values.
+    ///
+    /// @param percentile percentile in [0, 100], e.g., `99.9`
+    ///
+    /// @return uint64_t largest value of the bucket the percentile falls in,
+    ///                  at most `max()`
+    ///
+    [[nodiscard]] uint64_t percentile(double percentile) const {
+        const uint64_t n = count();
+        if (n == 0) { return 0; };
+        auto rank = static_cast<uint64_t>(
+            percentile / 100 * static_cast<double>(n) + 0.5);
+        rank = (rank == 0) ? 1 : rank;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKETS; i++) {
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+            seen += counts[i].load(std::memory_order_relaxed);
+            if (seen >= rank) { return std::min(upperBound(i), max()); };
+        };
+        return max();
+    };
+
+    /// @brief Remove every recorded value. Values recorded concurrently may be
+    ///        partially kept.
+    void reset() {
+        for (auto& bucket : counts) {
+            bucket.store(0, std::memory_order_relaxed);
+        };
+        total.store(0, std::memory_order_relaxed);
+        sum.store(0, std::memory_order_relaxed);
+        minimum.store(
+            std::numeric_limits<uint64_t>::max(), std::memory_order_relaxed);
+        maximum.store(0, std::memory_order_relaxed);
+    };
+
+  private:
+    static constexpr size_t SUB_BUCKETS = size_t { 1 } << SUB_BUCKET_BITS;
+    // magnitude 0 holds the exact values, every other one the values with
+    // the same most significant bit
+    static constexpr size_t BUCKETS = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    std::array<std::atomic<uint64_t>, BUCKETS> counts {};
+    std::atomic<uint64_t> total { 0 };
+    std::atomic<uint64_t> sum { 0 };
+    std::atomic<uint64_t> minimum { std::numeric_limits<uint64_t>::max() };
+    std::atomic<uint64_t> maximum { 0 };
+
+    static unsigned int mostSignificantBit(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+        return 63U - static_cast<unsigned int>(__builtin_clzll(value));
+#else
+        unsigned int bit = 0;
+        while ((value >>= 1U) != 0) { bit++; };
+        return bit;
+#endif
+    };
+
+    static size_t bucketOf(uint64_t value) {
+        if (value < SUB_BUCKETS) { return static_cast<size_t>(value); };
+        const unsigned int shift = mostSignificantBit(value) - SUB_BUCKET_BITS;
+        const size_t magnitude = shift + 1;
+        const auto sub = static_cast<size_t>(value >> shift) - SUB_BUCKETS;
+        return magnitude * SUB_BUCKETS + sub;
+    };
+
+    static uint64_t upperBound(size_t bucket) {
+        const size_t magnitude = bucket / SUB_BUCKETS;
+        const size_t sub = bucket % SUB_BUCKETS;
+        if (magnitude == 0) { return sub; };
+        const uint64_t lowest = uint64_t { SUB_BUCKETS + sub }
+                                << (magnitude - 1);
+        return lowest + ((uint64_t { 1 } << (magnitude - 1)) - 1);
+    };
+};
+
+///
+/// @brief Hot path statistics of a `ticker`.
+///
+/// Every histogram can be read from any thread while the ticker records to
+/// it. Statistics aren't recorded if `KITE_DISABLE_TICKER_STATS` is defined.
+///
+struct tickerStats {
+    /// Number of segments exchange lag is tracked for, indexed by the last
+    /// byte of instrument tokens.
+    static constexpr size_t SEGMENTS = 10;
+    /// Exchange lag is sampled from one in this many binary frames.
+    static constexpr uint64_t EXCHANGE_LAG_SAMPLE_INTERVAL = 16;
+
+    /// size of binary frames (bytes)
+    latencyHistogram frameSize;
+    /// number of packets in binary frames
+    latencyHistogram packetCount;
+    /// time spent processing a binary frame, excluding callbacks (ns)
+    latencyHistogram parseTime;
+    /// time spent in tick callbacks per binary frame (ns)
+    latencyHistogram callbackTime;
+    /// difference between the local time and the exchange timestamp of full
+    /// mode packets, by segment (ms), sampled every
+    /// `EXCHANGE_LAG_SAMPLE_INTERVAL` frames. Exchange timestamps have a
+    /// resolution of a second and negative lags are recorded as `0`.
+    std::array<latencyHistogram, SEGMENTS> exchangeLag;
+    /// monotonic time the last binary frame was received at (ns)
+    std::atomic<uint64_t> lastReceiveTime { 0 };
+
+    /// @brief Current time of the monotonic clock the ticker measures with
+    ///        (ns).
+    static uint64_t now() {
+        return static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch())
+                .count());
+    };
+
+    void reset() {
+        frameSize.reset();
+        packetCount.reset();
+        parseTime.reset();
+        callbackTime.reset();
+        for (latencyHistogram& lag : exchangeLag) { lag.reset(); };
+        lastReceiveTime.store(0, std::memory_order_relaxed);
+    };
+};
+
+} // namespace kiteconnect
@@ -0,0 +1,98 @@
+/*
+ *  Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+ *  SPDX-License-Identifier: MIT
+ *
+ *  Copyright (c) 2020-2022 Bhumit Attarde
+ *
+ *  Permission is hereby  granted, free of charge, to any  person obtaining a
+ * copy of this software and associated  documentation files (the "Software"),
+ * to deal in the Software  without restriction, including without  limitation
+ * the rights to  use, copy,  modify, merge,  publish, distribute,  sublicense,
+ * and/or  sell copies  of  the Software,  and  to  permit persons  to  whom the
+ * Software  is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS
+ * OR IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN
+ * NO EVENT  SHALL THE AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY
+ * CLAIM,  DAMAGES OR  OTHER LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT
+ * OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <functional>
+#include <utility>
+
+#include <uWS/uWS.h>
+
+namespace kiteconnect::internal {
+
+///
+/// @brief Timer on a uWS event loop that calls a `std::function`.
+///
+/// A one shot timer (\a repeat of `0`) is stopped before its callback is
+/// called, so the callback can start it again. A repeating timer must not be
+/// started again from its own callback.
+///
+class loopTimer {
+  public:
+    loopTimer() = default;
+    loopTimer(const loopTimer&) = delete;
+    loopTimer& operator=(const loopTimer&) = delete;
+    loopTimer(loopTimer&&) = delete;
+    loopTimer& operator=(loopTimer&&) = delete;
+    ~loopTimer() { stop(); };
+
+    ///
+    /// @brief Start the timer, restarting it if it's running.
+    ///
+    /// @param loop     loop the timer runs on
+    /// @param timeout  delay before the first call (ms)
+    /// @param repeat   interval between subsequent calls (ms), `0` for a one
+    ///                 shot timer
+    /// @param Callback called every time the timer fires
+    ///
+    void start(uS::Loop* loop, unsigned int timeout, unsigned int repeat,
+        std::function<void()> Callback) {
+        stop();
+        callback = std::move(Callback);
+        repeatInterval = repeat;
+        // NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
+        timer = new uS::Timer(loop);
+        timer->setData(this);
+        timer->start(fire, static_cast<int>(timeout), static_cast<int>(repeat));
+    };
+
+    void stop() {
+        if (timer == nullptr) { return; };
+        timer->stop();
+        // frees the timer once the loop is done with it
+        timer->close();
+        timer = nullptr;
+    };
+
+    [[nodiscard]] bool isActive() const { return timer != nullptr; };
+
+  private:
+    uS::Timer* timer = nullptr;
+    unsigned int repeatInterval = 0;
+    std::function<void()> callback;
+
+    static void fire(uS::Timer* Timer) {
+        auto* self = static_cast<loopTimer*>(Timer->getData());
+        if (self->repeatInterval != 0) {
+            self->callback();
+            return;
+        };
+        std::function<void()> oneShot = std::move(self->callback);
+        self->stop();
+        oneShot();
+    };
+};
+
+} // namespace kiteconnect::internal
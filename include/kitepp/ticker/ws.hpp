@@ -25,16 +25,20 @@
 
 #pragma once
 
-#include <algorithm> //reverse
+#include <array>
 #include <atomic>
+#include <charconv>
 #include <chrono>
 #include <cstdint>
-#include <cstring> //memcpy
 #include <functional>
+#include <future>
 #include <ios>
 #include <iostream>
 #include <limits>
+#include <memory>
+#include <random>
 #include <string>
+#include <string_view>
 #include <thread>
 #include <unordered_map>
 #include <utility>
@@ -44,6 +48,16 @@
 #include "../responses/responses.hpp"
 #include "../userconstants.hpp" //modes
 #include "../utils.hpp"
+#include "batch.hpp"
+#include "commands.hpp"
+#include "filter.hpp"
+#include "journal.hpp"
+#include "listener.hpp"
+#include "packet.hpp"
+#include "queue.hpp"
+#include "snapshot.hpp"
+#include "stats.hpp"
+#include "timer.hpp"
 
 #include "rapidjson/include/rapidjson/document.h"
 #include "rapidjson/include/rapidjson/rapidjson.h"
@@ -59,6 +73,11 @@ static_assert(std::numeric_limits<double>::is_iec559,
 using std::string;
 namespace kc = kiteconnect;
 
+namespace bench {
+// gives the parsing benchmarks access to the ticker's decoding
+class tickerAccess;
+} // namespace bench
+
 ///
 /// \brief \a ticker wraps around the websocket API provided by KiteConnect and
 ///         provides a native interface.
@@ -73,9 +92,42 @@ class ticker {
     /// @brief Called when ticks are received.
     std::function<void(ticker* ws, const std::vector<kc::tick>& ticks)> onTicks;
 
+    ///
+    /// @brief Called when ticks are received, with views over the received
+    ///        frame instead of decoded ticks.
+    ///
+    /// Fields are decoded only when they're read from a view, which makes
+    /// this considerably cheaper than `onTicks` when only a few fields (e.g.,
+    /// last price) are needed. Views are only valid until the callback
+    /// returns. Can be used along with `onTicks`.
+    ///
+    std::function<void(ticker* ws, const std::vector<kc::tickView>& ticks)>
+        onTickViews;
+
+    ///
+    /// @brief Called when ticks are received, with the ticks of the frame
+    ///        stored column-wise.
+    ///
+    /// Suited for consumers that scan a few fields across all ticks of a frame,
+    /// such as vectorised analytics. The batch is reused between frames and is
+    /// only valid until the callback returns. Can be used along with `onTicks`
+    /// and `onTickViews`.
+    ///
+    std::function<void(ticker* ws, const kc::tickBatch& batch)> onTickBatch;
+
     /// @brief Called when an order update is received.
     std::function<void(ticker* ws, const kc::postback& postback)> onOrderUpdate;
 
+    ///
+    /// @brief Called when an order update is received, without copying it.
+    ///
+    /// Order updates are parsed in place into reused memory, so unlike
+    /// `onOrderUpdate`, this doesn't allocate. The postback is only valid until
+    /// the callback returns. Can be used along with `onOrderUpdate`.
+    ///
+    std::function<void(ticker* ws, const kc::postbackView& postback)>
+        onOrderUpdateView;
+
     /// @brief Called when a message is received.
     std::function<void(ticker* ws, const string& message)> onMessage;
 
@@ -94,11 +146,13 @@ class ticker {
     ///       setting `EnableReconnect` to `true` in `ticker`'s constructor.
     ///       Auto reonnection mechanism is based on exponential backoff
     ///       algorithm in which next retry interval will be increased
-    ///       exponentially. MaxReconnectDelay and MaxReconnectTries params can
-    ///       be used to tweak the alogrithm. MaxReconnectDelay is the
-    ///       maximum delay after which subsequent reconnection interval will
-    ///       become constant and MaxReconnectTries is maximum number of retries
-    ///       before `ticker` quits trying to reconnect.
+    ///       exponentially. Each interval is randomly shortened by up to half
+    ///       so that clients don't retry in lockstep, and the event loop keeps
+    ///       running while waiting. MaxReconnectDelay and MaxReconnectTries
+    ///       params can be used to tweak the alogrithm. MaxReconnectDelay is
+    ///       the maximum delay after which subsequent reconnection interval
+    ///       will become constant and MaxReconnectTries is maximum number of
+    ///       retries before `ticker` quits trying to reconnect.
     ///
     std::function<void(ticker* ws, unsigned int attemptCount)> onTryReconnect;
 
@@ -175,27 +229,249 @@ class ticker {
     /// @brief Connect to the websocket server.
     void connect();
 
+    ///
+    /// @brief Connect to the websocket server, calling the handlers of
+    ///        \a listener.
+    ///
+    /// Tick handlers of \a listener are bound at compile time and called
+    /// straight from frame processing, without going through
+    /// `std::function`. \a listener has to outlive the connection.
+    ///
+    /// \note Every handler \a listener defines is also assigned to the
+    ///       `std::function` callback of the same name, silently replacing
+    ///       the one that was set before. Tick callbacks (`onTicks`,
+    ///       `onTickViews` and `onTickBatch`) it doesn't define aren't called
+    ///       while connected with it, other callbacks are kept.
+    ///
+    /// @param listener listener deriving from `kc::tickerListener`
+    ///
+    template <class Listener>
+    void connect(Listener& listener);
+
     /// @brief Check if client is connected.
     bool isConnected() const;
 
     ///
-    /// @brief Get the last time heartbeat was received. Should be used in
+    /// @brief Get the last time a frame (a heartbeat or any other) was
+    ///        received, the time the watchdog checks too. Should be used in
     ///        conjunction with the `isConnected()` method.
     ///
     /// @return std::chrono::time_point<std::chrono::system_clock> time
     ///
     std::chrono::time_point<std::chrono::system_clock> getLastBeatTime() const;
 
+    ///
+    /// @brief Decode ticks into a buffer owned by the caller.
+    ///
+    /// Ticks passed to `onTicks` are decoded into a buffer that is reused for
+    /// every frame, so once it has grown to fit the largest frame, delivering
+    /// ticks doesn't allocate. By default the buffer is owned by `ticker`.
+    /// Passing a buffer (e.g., one that has already been reserved to fit all
+    /// subscribed instruments) makes `ticker` decode into it instead. The
+    /// buffer's contents are only valid until the next frame is received.
+    ///
+    /// @param buffer buffer to decode ticks into, `nullptr` reverts to the
+    ///               buffer owned by `ticker`
+    ///
+    void setTickBuffer(std::vector<kc::tick>* buffer);
+
+    ///
+    /// @brief Keep the latest tick of every instrument in a store that can be
+    ///        read from any thread with `getLatestTick()`.
+    ///
+    /// Should be called before `connect()`. Ticks are stored whether or not
+    /// `onTicks` is set.
+    ///
+    /// @param capacity maximum number of instruments whose ticks are kept
+    ///
+    void enableSnapshots(size_t capacity = DEFAULT_SNAPSHOT_CAPACITY);
+
+    ///
+    /// @brief Get the latest tick of an instrument. Can be called from any
+    ///        thread, doesn't lock or allocate.
+    ///
+    /// @param instrumentToken instrument token of the instrument
+    /// @param Tick            set to the latest tick of the instrument
+    ///
+    /// @return bool `false` if snapshots aren't enabled or no tick has been
+    ///              received for the instrument
+    ///
+    bool getLatestTick(int32_t instrumentToken, kc::tick& Tick) const;
+
+    ///
+    /// @brief Push every received tick to a queue drained by another thread.
+    ///
+    /// Should be called before `run()`. The queue is owned by the caller and
+    /// must outlive `ticker` or be removed with `removeTickQueue()`. Ticks are
+    /// queued whether or not `onTicks` is set.
+    ///
+    /// @param queue queue ticks should be pushed to
+    ///
+    void addTickQueue(kc::tickQueue* queue);
+
+    ///
+    /// @brief Stop pushing ticks to a queue added with `addTickQueue()`.
+    ///
+    /// @param queue queue that should be removed
+    ///
+    void removeTickQueue(kc::tickQueue* queue);
+
+    ///
+    /// @brief Deliver at most one tick per instrument to `onTicks` every
+    ///        \a interval.
+    ///
+    /// The latest tick of every instrument is kept and all of them are passed
+    /// to `onTicks` together when the interval elapses, which bounds how often
+    /// `onTicks` is called regardless of market activity. Snapshots, tick
+    /// queues, `onTickViews` and `onTickBatch` still receive every tick.
+    ///
+    /// @param interval interval between deliveries (ms)
+    ///
+    /// @throw libException if \a interval is `0`
+    ///
+    void enableConflation(unsigned int interval);
+
+    /// @brief Deliver ticks as they're received again, pending conflated
+    ///        ticks are delivered first.
+    void disableConflation();
+
+    ///
+    /// @brief Get the number of ticks that were replaced by a newer tick of the
+    ///        same instrument while conflating.
+    ///
+    /// @return uint64_t number of merged ticks
+    ///
+    uint64_t getMergedTickCount() const;
+
+    ///
+    /// @brief Drop ticks whose fields in \a filter haven't changed since the
+    ///        last delivered tick of their instrument.
+    ///
+    /// Packets are compared by a fingerprint of their raw fields before
+    /// they're decoded, so dropped ticks cost no decoding and reach none of
+    /// the tick consumers. Subscriptions aren't affected.
+    ///
+    /// @param filter fields that are compared, `TICK_FILTER::NONE` delivers
+    ///               every tick
+    ///
+    void setTickFilter(kc::TICK_FILTER filter);
+
+    ///
+    /// @brief Get the number of ticks dropped by the filter set with
+    ///        `setTickFilter()`.
+    ///
+    /// @return uint64_t number of suppressed ticks
+    ///
+    uint64_t getSuppressedTickCount() const;
+
+#ifndef KITE_DISABLE_JOURNAL
+    ///
+    /// @brief Record every received frame to a journal.
+    ///
+    /// Binary and text frames are appended as they're received, before they're
+    /// processed, along with a monotonic receive timestamp. See `tickJournal`
+    /// for the file format. Replaces the journal that's currently enabled.
+    ///
+    /// The journal is read without synchronization when a frame is received,
+    /// so this and `disableJournal()` must be called before `connect()` or
+    /// from the event loop thread, e.g., in `onConnect`.
+    ///
+    /// @param pathPrefix  path journal segment files are named after
+    /// @param segmentSize size of a segment file (bytes)
+    ///
+    /// @throw libException if the journal can't be created
+    ///
+    void enableJournal(const string& pathPrefix,
+        size_t segmentSize = kc::tickJournal::DEFAULT_SEGMENT_SIZE);
+
+    ///
+    /// @brief Stop recording frames and close the journal.
+    ///
+    /// Must be called before `connect()` or from the event loop thread.
+    ///
+    void disableJournal();
+
+    ///
+    /// @brief Get the journal enabled with `enableJournal()`.
+    ///
+    /// @return const kc::tickJournal* journal, `nullptr` if it isn't enabled
+    ///
+    const kc::tickJournal* getJournal() const;
+#endif
+
+    ///
+    /// @brief Get statistics of the time taken to process frames, their sizes
+    ///        and how far ticks lag the exchange.
+    ///
+    /// Can be called from any thread. Nothing is recorded if
+    /// `KITE_DISABLE_TICKER_STATS` is defined.
+    ///
+    /// @return const kc::tickerStats& statistics of the ticker
+    ///
+    const kc::tickerStats& getStats() const;
+
+    /// @brief Remove every recorded statistic.
+    void resetStats();
+
+    ///
+    /// @brief Close the connection once it stops responding, so that it's
+    ///        reconnected if reconnection is enabled.
+    ///
+    /// A ping is sent every second and its round trip time is recorded. The
+    /// connection is considered dead if a pong doesn't arrive within
+    /// \a pongTimeout or no frame (ticks, heartbeats or text) is received for
+    /// \a frameTimeout. It's then closed with code `1006`, calling `onError`
+    /// and `onClose` like any other abnormal closure. Without the watchdog, a
+    /// half-open connection is only noticed once the OS gives up on it.
+    ///
+    /// @param pongTimeout  maximum time to wait for a pong (ms)
+    /// @param frameTimeout maximum time between received frames (ms)
+    ///
+    void enableWatchdog(unsigned int pongTimeout = DEFAULT_PONG_TIMEOUT,
+        unsigned int frameTimeout = DEFAULT_FRAME_TIMEOUT);
+
+    /// @brief Stop watching the connection.
+    void disableWatchdog();
+
+    ///
+    /// @brief Get the round trip times of the watchdog's pings (ns).
+    ///
+    /// Can be called from any thread, e.g., `getPingRtt().percentile(99)`.
+    ///
+    /// @return const kc::latencyHistogram& round trip times
+    ///
+    const kc::latencyHistogram& getPingRtt() const;
+
+    ///
+    /// @brief Get the number of times the watchdog closed an unresponsive
+    ///        connection.
+    ///
+    /// @return uint64_t number of closed connections
+    ///
+    uint64_t getWatchdogTimeoutCount() const;
+
+    ///
     /// @brief Start the client. Should always be called after `connect()`.
+    ///
+    /// Returns once the connection is closed for good: by `stop()`, by the
+    /// server with reconnection disabled, or after `onReconnectFail`. The
+    /// ticker's timers (e.g., conflation and the watchdog) are stopped then,
+    /// same as by `stop()`.
+    ///
     void run();
 
-    /// @brief Stop the client. Closes the connection if connected. Should be
-    ///        the last method that is called.
+    /// @brief Stop the client. Closes the connection if connected and stops
+    ///        every timer of the ticker. Should be the last method that is
+    ///        called.
     void stop();
 
     ///
     /// @brief Subscribe to a list of instrument tokens.
     ///
+    /// Subscription requests made within one iteration of the event loop are
+    /// coalesced and sent together once the iteration is done, in as few
+    /// frames as possible.
+    ///
     /// @param instrumentTokens list of instrument tokens that should be
     ///                         subscribed
     ///
@@ -218,24 +494,76 @@ class ticker {
      */
     void setMode(const string& mode, const std::vector<int>& instrumentTokens);
 
+    ///
+    /// @brief Subscribe to a list of instrument tokens from any thread.
+    ///
+    /// `subscribe()`, `unsubscribe()` and `setMode()` may only be called on
+    /// the thread running the event loop, e.g., from callbacks. The `Async`
+    /// variants queue the call to be made on that thread instead and return
+    /// without waiting for it. Should be called after `connect()`.
+    ///
+    /// @param instrumentTokens list of instrument tokens that should be
+    ///                         subscribed
+    ///
+    /// @return std::future<void> ready once the call has been made, holds a
+    ///         `kc::libException` if it failed or the connection has been
+    ///         closed for good (see `run()`). Waiting for it on the event
+    ///         loop's thread never returns.
+    ///
+    std::future<void> subscribeAsync(std::vector<int> instrumentTokens);
+
+    ///
+    /// @brief Unsubscribe from any thread. See `subscribeAsync()`.
+    ///
+    /// @param instrumentTokens list of instrument tokens that should be
+    ///                         unsubscribed
+    ///
+    /// @return std::future<void> ready once the call has been made
+    ///
+    std::future<void> unsubscribeAsync(std::vector<int> instrumentTokens);
+
+    ///
+    /// @brief Set the subscription mode for a list of instrument tokens from
+    ///        any thread. See `subscribeAsync()`.
+    ///
+    /// @param mode             mode to set
+    /// @param instrumentTokens list of instrument tokens whose mode should be
+    ///                         set
+    ///
+    /// @return std::future<void> ready once the call has been made
+    ///
+    std::future<void> setModeAsync(
+        string mode, std::vector<int> instrumentTokens);
+
   private:
     friend class tickerTest_binaryParsingTest_Test;
+    friend class tickerTest_truncatedBinaryMessageTest_Test;
+    friend class tickerTest_tickBufferReuseTest_Test;
+    friend class tickerTest_tickViewTest_Test;
+    friend class tickerTest_tickBatchTest_Test;
+    friend class tickerTest_snapshotTest_Test;
+    friend class tickerTest_tickQueueTest_Test;
+    friend class tickerTest_shardedTickerTest_Test;
+    friend class tickerTest_conflationTest_Test;
+    friend class tickerTest_tickFilterTest_Test;
+    friend class tickerTest_statsTest_Test;
+    friend class tickerTest_orderUpdateTest_Test;
+    friend class tickerTest_requestCoalescingTest_Test;
+    friend class tickerTest_resubscribeTest_Test;
+    friend class tickerTest_reconnectTest_Test;
+    friend class tickerTest_watchdogTest_Test;
+    friend class tickerTest_redundantTickerTest_Test;
+    friend class tickerTest_commandQueueTest_Test;
+    friend class tickerTest_listenerTest_Test;
+    friend class bench::tickerAccess;
+    friend class candleAggregator;
+    friend class redundantTicker;
+    friend class shardedTicker;
+    friend class tickReplay;
     const string connectUrlFmt =
         "wss://ws.kite.trade/?api_key={0}&access_token={1}";
     string key;
     string token;
-    enum class SEGMENTS : int
-    {
-        NSE = 1,
-        NFO,
-        CDS,
-        BSE,
-        BFO,
-        BSECDS,
-        MCX,
-        MCXSX,
-        INDICES
-    };
     enum class MODES
     {
         LTP,
@@ -243,15 +571,79 @@ class ticker {
         FULL
     };
     const MODES DEFAULT_MODE = MODES::QUOTE;
+    enum class REQUEST
+    {
+        SUBSCRIBE,
+        UNSUBSCRIBE,
+        MODE
+    };
+    // subscription changes of an instrument that haven't been sent yet
+    struct pendingRequest {
+        bool unsubscribe = false;
+        bool subscribe = false;
+        bool setsMode = false;
+        MODES mode = MODES::QUOTE;
+    };
     std::unordered_map<int, MODES> subbedInstruments;
-    uWS::Hub hub;
+    std::unique_ptr<kc::tickSnapshots> snapshots;
+    std::vector<kc::tickQueue*> tickQueues;
+    // latest tick of every instrument since the last delivery, in the order
+    // the instruments were first seen, and their positions in it
+    std::vector<kc::tick> conflatedTicks;
+    std::unordered_map<int32_t, size_t> conflatedIndex;
+    std::atomic<uint64_t> mergedTicks { 0 };
+    kc::TICK_FILTER tickFilter = kc::TICK_FILTER::NONE;
+    std::unordered_map<int32_t, uint64_t> tickFingerprints;
+    std::atomic<uint64_t> suppressedTicks { 0 };
+#ifndef KITE_DISABLE_JOURNAL
+    std::unique_ptr<kc::tickJournal> journal;
+#endif
+#ifndef KITE_DISABLE_TICKER_STATS
+    kc::tickerStats stats;
+    uint64_t lagSampleFrames = 0;
+#endif
+    // set unless the hub is shared with other tickers
+    std::unique_ptr<uWS::Hub> ownedHub;
+    uWS::Hub* hub;
     // NOLINTNEXTLINE(readability-implicit-bool-conversion)
     uWS::Group<uWS::CLIENT>* group;
     // NOLINTNEXTLINE(readability-implicit-bool-conversion)
     uWS::WebSocket<uWS::CLIENT>* ws = nullptr;
+    // instruments with pending requests, in the order they were first
+    // requested, and their requests
+    std::vector<int> pendingTokens;
+    std::unordered_map<int, pendingRequest> pendingRequests;
+    // timers are declared after the hub so that they're stopped before its
+    // loop is destroyed
+    internal::loopTimer conflationTimer;
+    internal::loopTimer requestTimer;
+    // delays the next reconnect attempt
+    internal::loopTimer reconnectTimer;
+    internal::loopTimer watchdogTimer;
+    // calls made from other threads
+    internal::commandQueue commands;
+    uint64_t pongTimeout = 0;  // ns
+    uint64_t frameTimeout = 0; // ns
+    // monotonic times of the last received frame (heartbeats included) and of
+    // the ping awaiting a pong, `0` if there's none (ns)
+    uint64_t lastBeatTime = 0;
+    uint64_t pingSentTime = 0;
+    kc::latencyHistogram pingRtt;
+    std::atomic<uint64_t> watchdogTimeouts { 0 };
+    // requests are encoded here before they're sent
+    string requestBuffer;
+    std::vector<int> requestTokens;
+    // requests larger than this are split into multiple frames
+    static constexpr size_t DEFAULT_MAX_REQUEST_SIZE = 16384; // bytes
+    size_t maxRequestSize = DEFAULT_MAX_REQUEST_SIZE;
     static constexpr unsigned int DEFAULT_CONNECT_TIMEOUT = 5;      // s
     static constexpr unsigned int DEFAULT_MAX_RECONNECT_DELAY = 60; // s
     static constexpr unsigned int DEFAULT_MAX_RECONNECT_TRIES = 30;
+    // maximum number of instruments a single connection can subscribe to
+    static constexpr size_t DEFAULT_SNAPSHOT_CAPACITY = 3000;
+    static constexpr unsigned int DEFAULT_PONG_TIMEOUT = 5000;  // ms
+    static constexpr unsigned int DEFAULT_FRAME_TIMEOUT = 5000; // ms
+    static constexpr unsigned int WATCHDOG_INTERVAL = 1000;     // ms
     const unsigned int connectTimeout = DEFAULT_CONNECT_TIMEOUT; // ms
     const string pingMessage;
     const unsigned int pingInterval = 3000; // ms
@@ -260,26 +652,181 @@ class ticker {
     unsigned int reconnectDelay = initReconnectDelay;
     const unsigned int maxReconnectDelay = DEFAULT_MAX_RECONNECT_DELAY; // s
     unsigned int reconnectTries = 0;
+    // randomises reconnect delays
+    std::minstd_rand reconnectJitter { std::random_device {}() };
     const unsigned int maxReconnectTries = DEFAULT_MAX_RECONNECT_TRIES;
     std::atomic<bool> isReconnecting { false };
-    std::chrono::time_point<std::chrono::system_clock> lastPongTime;
-    std::chrono::time_point<std::chrono::system_clock> lastBeatTime;
+    std::vector<kc::tick> tickBuffer;
+    std::vector<kc::tick>* userTickBuffer = nullptr;
+    std::vector<kc::tickView> tickViewBuffer;
+    kc::tickBatch tickBatchBuffer;
+    // text frames are copied here to be parsed in place
+    std::vector<char> textBuffer;
+    // memory of the document text frames are parsed into, followed by the
+    // memory of the parser's stack
+    std::vector<char> textPool;
+    static constexpr size_t TEXT_VALUE_POOL_SIZE = 16384;
+    static constexpr size_t TEXT_STACK_POOL_SIZE = 4096;
+    static constexpr size_t TEXT_STACK_CAPACITY = 1024;
+
+    // calls the std::function tick callbacks
+    struct functionCallbacks {
+        ticker* ws;
+
+        [[nodiscard]] bool hasTicks() const {
+            return static_cast<bool>(ws->onTicks);
+        };
+        [[nodiscard]] bool hasTickViews() const {
+            return static_cast<bool>(ws->onTickViews);
+        };
+        [[nodiscard]] bool hasTickBatch() const {
+            return static_cast<bool>(ws->onTickBatch);
+        };
+        void ticks(const std::vector<kc::tick>& Ticks) const {
+            ws->onTicks(ws, Ticks);
+        };
+        void tickViews(const std::vector<kc::tickView>& Ticks) const {
+            ws->onTickViews(ws, Ticks);
+        };
+        void tickBatch(const kc::tickBatch& batch) const {
+            ws->onTickBatch(ws, batch);
+        };
+    };
+
+    // calls a listener's tick handlers directly
+    template <class Listener>
+    struct listenerCallbacks {
+        using handlers = internal::listenerHandlers<Listener>;
+        ticker* ws;
+        Listener* listener;
+
+        static constexpr bool hasTicks() { return handlers::ON_TICKS; };
+        static constexpr bool hasTickViews() {
+            return handlers::ON_TICK_VIEWS;
+        };
+        static constexpr bool hasTickBatch() {
+            return handlers::ON_TICK_BATCH;
+        };
+        void ticks(const std::vector<kc::tick>& Ticks) const {
+            listener->onTicks(ws, Ticks);
+        };
+        void tickViews(const std::vector<kc::tickView>& Ticks) const {
+            listener->onTickViews(ws, Ticks);
+        };
+        void tickBatch(const kc::tickBatch& batch) const {
+            listener->onTickBatch(ws, batch);
+        };
+    };
+
+    // NOLINTNEXTLINE(bugprone-easily-swappable-parameters)
+    ticker(string Key, uWS::Hub* Hub, unsigned int ConnectTimeout,
+        bool EnableReconnect, unsigned int MaxReconnectDelay,
+        unsigned int MaxReconnectTries);
+
+    static MODES parseMode(const string& mode);
+
+    static const string& modeName(MODES mode);
 
     void connectInternal();
 
+    // runs \a command on the loop's thread
+    std::future<void> runOnLoop(std::function<void()> command);
+
+    // schedules the next reconnect attempt
     void reconnect();
 
-    void processTextMessage(const string& message);
+    // closes the handles that keep the loop running once the ticker won't
+    // connect again by itself, so that `run()` returns
+    void releaseLoop();
+
+    void processDisconnection(int code, const string& reason);
+
+    // delay before the next reconnect attempt with jitter applied (ms)
+    unsigned int nextReconnectDelay();
+
+    // dispatches a received frame, shared by the websocket and replays
+    void processMessage(char* message, size_t length, uWS::OpCode opCode);
+
+    // tick callbacks are called through \a callbacks
+    template <class Callbacks>
+    void processMessage(char* message, size_t length, uWS::OpCode opCode,
+        const Callbacks& callbacks);
+
+    void processTextMessage(const char* message, size_t length);
+
+    // reads the top level type of a text frame without parsing it, empty if
+    // it can't be found, in which case the frame is parsed
+    static std::string_view messageType(const char* message, size_t length);
+
+    template <class Callbacks>
+    [[nodiscard]] bool hasTickConsumers(const Callbacks& callbacks) const;
+
+    void processBinaryMessage(char* message, size_t length);
+
+    template <class Callbacks>
+    void processBinaryMessage(
+        char* message, size_t length, const Callbacks& callbacks);
+
+    // monotonic time statistics are measured with (ns), `0` if they're
+    // disabled so that measuring compiles away
+    static uint64_t statsTime();
+
+    // records the frame's size and samples the exchange lag of its packets
+    void recordFrameStats(const char* message, size_t length);
+
+    void recordTimeStats(uint64_t receiveTime, uint64_t callbackTime);
+
+    // drops unchanged packets by compacting the frame in place, returns its
+    // new length
+    size_t suppressUnchanged(char* message, size_t length);
+
+    void conflate(const std::vector<kc::tick>& ticks);
+
+    void flushConflated();
 
     template <typename T>
-    T unpack(const std::vector<char>& bytes, size_t start, size_t end);
+    static T unpack(const char* bytes, size_t start);
 
-    std::vector<std::vector<char>> splitPackets(const std::vector<char>& bytes);
+    template <class Visitor>
+    size_t splitPackets(const char* bytes, size_t size, Visitor&& visit);
+
+    kc::tick parsePacket(const char* packet, size_t packetSize);
+
+    void parseBinaryMessage(
+        char* bytes, size_t size, std::vector<kc::tick>& ticks);
 
     std::vector<kc::tick> parseBinaryMessage(char* bytes, size_t size);
 
+    void parseBinaryMessage(char* bytes, size_t size, kc::tickBatch& batch);
+
+    // coalesces a request with the pending ones and schedules sending them
+    void queueRequest(REQUEST request, const std::vector<int>& instrumentTokens,
+        MODES mode = MODES::QUOTE);
+
+    void flushRequests();
+
+    // encodes pending requests into frames and passes them to \a send, in
+    // the order unsubscribe, subscribe, mode
+    template <class Sender>
+    void encodeRequests(Sender&& send);
+
+    // \a mode is empty unless \a action is `mode`
+    template <class Sender>
+    void encodeRequest(std::string_view action, std::string_view mode,
+        const std::vector<int>& instrumentTokens, Sender& send);
+
+    // closes the connection if it's dead and pings it otherwise
+    void watch();
+
+    [[nodiscard]] bool isAlive(uint64_t now) const;
+
+    // records the round trip time of the watchdog's pings
+    void processPong(const char* message, size_t length, uint64_t now);
+
     void resubInstruments();
 
-    void assignCallbacks();
+    // frames are dispatched through \a callbacks
+    template <class Callbacks>
+    void assignCallbacks(Callbacks callbacks);
 };
 } // namespace kiteconnect
\ No newline at end of file
@@ -26,7 +26,10 @@
 #pragma once
 
 #include <cstdint>
+#include <cstdlib> //_byteswap_*
+#include <cstring>
 #include <functional>
+#include <new>
 #include <optional>
 #include <string>
 #include <type_traits>
@@ -579,6 +582,96 @@ void addParam(http::Params& bodyParams, Param& param, const string& fieldName) {
     }
 };
 
+///
+/// @brief Allocator that aligns allocations to \a Alignment bytes (e.g., to
+///        cache lines or SIMD registers).
+///
+template <class T, size_t Alignment>
+struct alignedAllocator {
+    static_assert(Alignment >= alignof(T) && (Alignment & (Alignment - 1)) == 0,
+        "Alignment must be a power of two not smaller than alignof(T)");
+    using value_type = T;
+    template <class U>
+    struct rebind {
+        using other = alignedAllocator<U, Alignment>;
+    };
+
+    alignedAllocator() = default;
+    template <class U>
+    // NOLINTNEXTLINE(google-explicit-constructor, hicpp-explicit-conversions)
+    alignedAllocator(const alignedAllocator<U, Alignment>& /*other*/) noexcept {
+    }
+
+    [[nodiscard]] T* allocate(size_t n) {
+        return static_cast<T*>(
+            ::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+    };
+
+    void deallocate(T* ptr, size_t /*n*/) noexcept {
+        ::operator delete(ptr, std::align_val_t(Alignment));
+    };
+
+    template <class U>
+    bool operator==(const alignedAllocator<U, Alignment>& /*rhs*/) const {
+        return true;
+    };
+
+    template <class U>
+    bool operator!=(const alignedAllocator<U, Alignment>& /*rhs*/) const {
+        return false;
+    };
+};
+
+namespace bytes {
+
+///
+/// @brief Reverse the byte order of an unsigned integer.
+///
+template <class T>
+inline T byteswap(T value) noexcept {
+    static_assert(std::is_unsigned_v<T> &&
+                      (sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8),
+        "T must be a 16, 32 or 64 bit unsigned integer");
+#if defined(__GNUC__) || defined(__clang__)
+    if constexpr (sizeof(T) == 2) { return __builtin_bswap16(value); }
+    if constexpr (sizeof(T) == 4) { return __builtin_bswap32(value); }
+    if constexpr (sizeof(T) == 8) { return __builtin_bswap64(value); }
+#elif defined(_MSC_VER)
+    if constexpr (sizeof(T) == 2) { return _byteswap_ushort(value); }
+    if constexpr (sizeof(T) == 4) { return _byteswap_ulong(value); }
+    if constexpr (sizeof(T) == 8) { return _byteswap_uint64(value); }
+#else
+    // NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers, hicpp-signed-bitwise)
+    T swapped = 0;
+    for (size_t i = 0; i < sizeof(T); i++) {
+        swapped = static_cast<T>((swapped << 8) | (value & 0xff));
+        value = static_cast<T>(value >> 8);
+    };
+    return swapped;
+    // NOLINTEND(cppcoreguidelines-avoid-magic-numbers, hicpp-signed-bitwise)
+#endif
+};
+
+///
+/// @brief Read a big-endian (network byte order) integer stored at \a bytes.
+///        \a bytes doesn't need to be aligned.
+///
+template <class T>
+inline T readBigEndian(const char* bytes) noexcept {
+    static_assert(std::is_integral_v<T>, "T must be an integer");
+    using Unsigned = std::make_unsigned_t<T>;
+    Unsigned raw = 0;
+    std::memcpy(&raw, bytes, sizeof(Unsigned));
+    // clang-format off
+    #ifndef WORDS_BIGENDIAN
+    raw = byteswap(raw);
+    #endif
+    // clang-format on
+    return static_cast<T>(raw);
+};
+
+} // namespace bytes
+
 template <class Instrument>
 inline std::vector<Instrument> parseInstruments(const std::string& data) {
     static_assert(std::is_constructible_v<Instrument, std::vector<string>>,
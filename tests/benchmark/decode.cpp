@@ -0,0 +1,141 @@
+/*
+ *  Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+ *  SPDX-License-Identifier: MIT
+ *
+ *  Copyright (c) 2020-2022 Bhumit Attarde
+ *
+ *  Permission is hereby  granted, free of charge, to any  person obtaining a
+ * copy of this software and associated  documentation files (the "Software"),
+ * to deal in the Software  without restriction, including without  limitation
+ * the rights to  use, copy,  modify, merge,  publish, distribute,  sublicense,
+ * and/or  sell copies  of  the Software,  and  to  permit persons  to  whom the
+ * Software  is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS
+ * OR IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN
+ * NO EVENT  SHALL THE AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY
+ * CLAIM,  DAMAGES OR  OTHER LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT
+ * OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "kitepp.hpp"
+
+namespace kiteconnect::bench {
+
+namespace utils = kiteconnect::internal::utils;
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+constexpr size_t FULL_PACKET_SIZE = 184;
+constexpr size_t DEPTH_START_IDX = 64;
+constexpr size_t DEPTH_ENTRY_SIZE = 12;
+constexpr size_t DEPTH_ENTRIES = 10;
+
+// a full mode packet with every 4 byte field set to its offset
+std::array<char, FULL_PACKET_SIZE> makeFullPacket() {
+    std::array<char, FULL_PACKET_SIZE> packet {};
+    for (size_t i = 0; i < FULL_PACKET_SIZE; i += 4) {
+        const auto value = utils::bytes::byteswap(static_cast<uint32_t>(i));
+        std::memcpy(packet.data() + i, &value, sizeof(value));
+    };
+    return packet;
+}
+
+// the decoding primitive used by the ticker before it switched to byteswaps
+template <typename T>
+T legacyUnpack(const std::vector<char>& bytes, size_t start, size_t end) {
+    T value;
+    std::vector<char> requiredBytes(bytes.begin() + static_cast<int64_t>(start),
+        bytes.begin() + static_cast<int64_t>(end) + 1);
+    std::reverse(requiredBytes.begin(), requiredBytes.end());
+    std::memcpy(&value, requiredBytes.data(), sizeof(T));
+    return value;
+}
+
+// decodes the same ~50 fields the ticker decodes from a full packet
+void BM_legacyUnpackFullPacket(benchmark::State& state) {
+    const auto raw = makeFullPacket();
+    const std::vector<char> packet(raw.begin(), raw.end());
+    for (auto _ : state) {
+        int64_t sum = 0;
+        for (size_t i = 0; i < DEPTH_START_IDX; i += 4) {
+            sum += legacyUnpack<int32_t>(packet, i, i + 3);
+        };
+        for (size_t i = 0; i < DEPTH_ENTRIES; i++) {
+            const size_t idx = DEPTH_START_IDX + (i * DEPTH_ENTRY_SIZE);
+            sum += legacyUnpack<int32_t>(packet, idx, idx + 3);
+            sum += legacyUnpack<int32_t>(packet, idx + 4, idx + 7);
+            sum += legacyUnpack<int16_t>(packet, idx + 8, idx + 9);
+        };
+        benchmark::DoNotOptimize(sum);
+    };
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_legacyUnpackFullPacket);
+
+void BM_readBigEndianFullPacket(benchmark::State& state) {
+    const auto packet = makeFullPacket();
+    for (auto _ : state) {
+        int64_t sum = 0;
+        for (size_t i = 0; i < DEPTH_START_IDX; i += 4) {
+            sum += utils::bytes::readBigEndian<int32_t>(packet.data() + i);
+        };
+        for (size_t i = 0; i < DEPTH_ENTRIES; i++) {
+            const char* entry =
+                packet.data() + DEPTH_START_IDX + (i * DEPTH_ENTRY_SIZE);
+            sum += utils::bytes::readBigEndian<int32_t>(entry);
+            sum += utils::bytes::readBigEndian<int32_t>(entry + 4);
+            sum += utils::bytes::readBigEndian<int16_t>(entry + 8);
+        };
+        benchmark::DoNotOptimize(sum);
+    };
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_readBigEndianFullPacket);
+
+void BM_depth(benchmark::State& state, internal::depth::decoder decode) {
+    const auto packet = makeFullPacket();
+    internal::depth::levels levels;
+    for (auto _ : state) {
+        decode(packet.data() + DEPTH_START_IDX, 100.0, levels);
+        benchmark::DoNotOptimize(levels);
+    };
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_CAPTURE(BM_depth, scalar, internal::depth::decodeScalar);
+BENCHMARK_CAPTURE(BM_depth, dispatched, internal::depth::decode);
+
+#ifdef KITE_DEPTH_SIMD
+void BM_depthSSE41(benchmark::State& state) {
+    if (!__builtin_cpu_supports("sse4.1")) {
+        state.SkipWithError("SSE4.1 isn't supported");
+        return;
+    };
+    BM_depth(state, internal::depth::decodeSSE41);
+}
+BENCHMARK(BM_depthSSE41);
+
+void BM_depthAVX2(benchmark::State& state) {
+    if (!__builtin_cpu_supports("avx2")) {
+        state.SkipWithError("AVX2 isn't supported");
+        return;
+    };
+    BM_depth(state, internal::depth::decodeAVX2);
+}
+BENCHMARK(BM_depthAVX2);
+#endif
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
+
+} // namespace kiteconnect::bench
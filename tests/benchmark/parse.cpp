@@ -0,0 +1,274 @@
+/*
+ *  Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+ *  SPDX-License-Identifier: MIT
+ *
+ *  Copyright (c) 2020-2022 Bhumit Attarde
+ *
+ *  Permission is hereby  granted, free of charge, to any  person obtaining a
+ * copy of this software and associated  documentation files (the "Software"),
+ * to deal in the Software  without restriction, including without  limitation
+ * the rights to  use, copy,  modify, merge,  publish, distribute,  sublicense,
+ * and/or  sell copies  of  the Software,  and  to  permit persons  to  whom the
+ * Software  is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE  IS PROVIDED "AS  IS", WITHOUT WARRANTY  OF ANY KIND,  EXPRESS
+ * OR IMPLIED,  INCLUDING BUT  NOT  LIMITED TO  THE  WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR  A PARTICULAR PURPOSE AND  NONINFRINGEMENT. IN
+ * NO EVENT  SHALL THE AUTHORS  OR COPYRIGHT  HOLDERS  BE  LIABLE FOR  ANY
+ * CLAIM,  DAMAGES OR  OTHER LIABILITY, WHETHER IN AN ACTION OF  CONTRACT, TORT
+ * OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE  OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "kitepp.hpp"
+
+// counts heap allocations so that allocations per frame can be reported
+#if defined(__GNUC__) && !defined(__clang__)
+// the replacement delete frees memory from the replacement new, which GCC
+// can't tell apart from a mismatched free
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+namespace {
+std::atomic<uint64_t> allocations { 0 };
+} // namespace
+
+void* operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size)) { return memory; };
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+
+void operator delete(void* memory, size_t /*size*/) noexcept {
+    ::operator delete(memory);
+}
+
+// used by over-aligned types, e.g., the columns of kc::tickBatch
+void* operator new(size_t size, std::align_val_t alignment) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    const auto align = static_cast<size_t>(alignment);
+    // the size passed to aligned_alloc must be a multiple of the alignment
+    const size_t rounded = (std::max<size_t>(size, 1) + align - 1) / align;
+    if (void* memory = std::aligned_alloc(align, rounded * align)) {
+        return memory;
+    };
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory, std::align_val_t /*alignment*/) noexcept {
+    std::free(memory);
+}
+
+void operator delete(
+    void* memory, size_t /*size*/, std::align_val_t alignment) noexcept {
+    ::operator delete(memory, alignment);
+}
+
+namespace kiteconnect::bench {
+
+namespace utils = kiteconnect::internal::utils;
+namespace packet = kiteconnect::internal::packet;
+namespace segment = kiteconnect::internal::segment;
+
+class tickerAccess {
+  public:
+    template <class Visitor>
+    static size_t splitPackets(
+        ticker& Ticker, const char* bytes, size_t size, Visitor&& visit) {
+        return Ticker.splitPackets(bytes, size, visit);
+    };
+
+    static void parse(ticker& Ticker, char* bytes, size_t size,
+        std::vector<kc::tick>& ticks) {
+        Ticker.parseBinaryMessage(bytes, size, ticks);
+    };
+
+    static void parse(
+        ticker& Ticker, char* bytes, size_t size, kc::tickBatch& batch) {
+        Ticker.parseBinaryMessage(bytes, size, batch);
+    };
+
+    static void process(ticker& Ticker, char* bytes, size_t size) {
+        Ticker.processBinaryMessage(bytes, size);
+    };
+
+    template <class Listener>
+    static void process(
+        ticker& Ticker, char* bytes, size_t size, Listener& listener) {
+        Ticker.processBinaryMessage(bytes, size,
+            ticker::listenerCallbacks<Listener> { &Ticker, &listener });
+    };
+};
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-magic-numbers)
+enum MODE : int64_t
+{
+    LTP,
+    QUOTE,
+    FULL
+};
+
+template <typename T> void write(std::vector<char>& frame, T value) {
+    const T swapped = utils::bytes::byteswap(value);
+    const size_t offset = frame.size();
+    frame.resize(offset + sizeof(T));
+    std::memcpy(&frame[offset], &swapped, sizeof(T));
+}
+
+// a frame of \a packets packets of instruments in segment \a seg
+std::vector<char> makeFrame(int64_t packets, MODE mode, segment::SEGMENTS seg) {
+    std::vector<char> frame;
+    write(frame, static_cast<uint16_t>(packets));
+    const size_t size = (mode == LTP)     ? packet::LTP_SIZE
+                        : (mode == QUOTE) ? packet::QUOTE_SIZE
+                                          : packet::FULL_SIZE;
+    for (int64_t i = 0; i < packets; i++) {
+        write(frame, static_cast<uint16_t>(size));
+        const size_t start = frame.size();
+        write(frame,
+            static_cast<uint32_t>(((i + 1) << 8) | static_cast<int64_t>(seg)));
+        // prices around 1000, quantities & times increasing with the field
+        while (frame.size() - start < size) {
+            write(frame, static_cast<uint32_t>(100000 + frame.size() - start));
+        };
+    };
+    return frame;
+}
+
+void setCounters(
+    benchmark::State& state, int64_t packets, uint64_t allocated) {
+    state.counters["time/packet"] = benchmark::Counter(
+        static_cast<double>(packets),
+        benchmark::Counter::kIsIterationInvariantRate |
+            benchmark::Counter::kInvert);
+    state.counters["allocs/frame"] = benchmark::Counter(
+        static_cast<double>(allocated), benchmark::Counter::kAvgIterations);
+    state.SetItemsProcessed(state.iterations() * packets);
+}
+
+std::vector<char> frameOf(const benchmark::State& state) {
+    return makeFrame(state.range(0), static_cast<MODE>(state.range(1)),
+        static_cast<segment::SEGMENTS>(state.range(2)));
+}
+
+void BM_splitPackets(benchmark::State& state) {
+    kc::ticker Ticker("apikey");
+    const std::vector<char> frame = frameOf(state);
+    const uint64_t before = allocations.load(std::memory_order_relaxed);
+    for (auto _ : state) {
+        size_t bytes = 0;
+        tickerAccess::splitPackets(Ticker, frame.data(), frame.size(),
+            [&](const char* /*packet*/, size_t size) { bytes += size; });
+        benchmark::DoNotOptimize(bytes);
+    };
+    setCounters(state, state.range(0),
+        allocations.load(std::memory_order_relaxed) - before);
+}
+
+void BM_parseTicks(benchmark::State& state) {
+    kc::ticker Ticker("apikey");
+    std::vector<char> frame = frameOf(state);
+    std::vector<kc::tick> ticks;
+    // the buffer is reused across frames, like the ticker does
+    tickerAccess::parse(Ticker, frame.data(), frame.size(), ticks);
+    const uint64_t before = allocations.load(std::memory_order_relaxed);
+    for (auto _ : state) {
+        tickerAccess::parse(Ticker, frame.data(), frame.size(), ticks);
+        benchmark::DoNotOptimize(ticks.data());
+    };
+    setCounters(state, state.range(0),
+        allocations.load(std::memory_order_relaxed) - before);
+}
+
+void BM_parseBatch(benchmark::State& state) {
+    kc::ticker Ticker("apikey");
+    std::vector<char> frame = frameOf(state);
+    kc::tickBatch batch;
+    tickerAccess::parse(Ticker, frame.data(), frame.size(), batch);
+    const uint64_t before = allocations.load(std::memory_order_relaxed);
+    for (auto _ : state) {
+        tickerAccess::parse(Ticker, frame.data(), frame.size(), batch);
+        benchmark::DoNotOptimize(batch.lastPrice.data());
+    };
+    setCounters(state, state.range(0),
+        allocations.load(std::memory_order_relaxed) - before);
+}
+
+struct sumListener : kc::tickerListener<sumListener> {
+    kc::Price sum = 0;
+
+    void onTicks(kc::ticker* /*ws*/, const std::vector<kc::tick>& ticks) {
+        for (const kc::tick& Tick : ticks) { sum += Tick.lastPrice; };
+    };
+};
+
+void BM_dispatchFunction(benchmark::State& state) {
+    kc::ticker Ticker("apikey");
+    std::vector<char> frame = frameOf(state);
+    kc::Price sum = 0;
+    Ticker.onTicks = [&](kc::ticker* /*ws*/,
+                         const std::vector<kc::tick>& ticks) {
+        for (const kc::tick& Tick : ticks) { sum += Tick.lastPrice; };
+    };
+    tickerAccess::process(Ticker, frame.data(), frame.size());
+    const uint64_t before = allocations.load(std::memory_order_relaxed);
+    for (auto _ : state) {
+        tickerAccess::process(Ticker, frame.data(), frame.size());
+    };
+    benchmark::DoNotOptimize(sum);
+    setCounters(state, state.range(0),
+        allocations.load(std::memory_order_relaxed) - before);
+}
+
+void BM_dispatchListener(benchmark::State& state) {
+    kc::ticker Ticker("apikey");
+    std::vector<char> frame = frameOf(state);
+    sumListener listener;
+    tickerAccess::process(Ticker, frame.data(), frame.size(), listener);
+    const uint64_t before = allocations.load(std::memory_order_relaxed);
+    for (auto _ : state) {
+        tickerAccess::process(Ticker, frame.data(), frame.size(), listener);
+    };
+    benchmark::DoNotOptimize(listener.sum);
+    setCounters(state, state.range(0),
+        allocations.load(std::memory_order_relaxed) - before);
+}
+
+// packets per frame x mode x segment
+void frameArgs(benchmark::internal::Benchmark* bench) {
+    bench->ArgNames({ "packets", "mode", "segment" });
+    bench->ArgsProduct({ { 1, 100, 3000 }, { LTP, QUOTE, FULL },
+        { static_cast<int64_t>(segment::SEGMENTS::NSE),
+            static_cast<int64_t>(segment::SEGMENTS::CDS),
+            static_cast<int64_t>(segment::SEGMENTS::BSECDS) } });
+}
+
+BENCHMARK(BM_splitPackets)->Apply(frameArgs);
+BENCHMARK(BM_parseTicks)->Apply(frameArgs);
+BENCHMARK(BM_parseBatch)->Apply(frameArgs);
+BENCHMARK(BM_dispatchFunction)
+    ->ArgNames({ "packets", "mode", "segment" })
+    ->ArgsProduct({ { 1, 100 }, { LTP, FULL },
+        { static_cast<int64_t>(segment::SEGMENTS::NSE) } });
+BENCHMARK(BM_dispatchListener)
+    ->ArgNames({ "packets", "mode", "segment" })
+    ->ArgsProduct({ { 1, 100 }, { LTP, FULL },
+        { static_cast<int64_t>(segment::SEGMENTS::NSE) } });
+// NOLINTEND(cppcoreguidelines-avoid-magic-numbers)
+
+} // namespace kiteconnect::bench
@@ -23,8 +23,15 @@
  * USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
 #include <fstream>
+#include <future>
 #include <iterator>
+#include <map>
+#include <random>
+#include <thread>
 #include <vector>
 
 #include <gtest/gtest.h>
@@ -35,138 +42,1572 @@ namespace kiteconnect {
 
 namespace kc = kiteconnect;
 
+// frame holding full mode ticks of two instruments
+constexpr const char* TICKS_FRAME = "../tests/mock_custom/websocket_ticks.bin";
+
+std::vector<char> loadTicksFrame() {
+    std::ifstream dataFile(TICKS_FRAME, std::ios::binary);
+    if (!dataFile) { ADD_FAILURE() << "can't open " << TICKS_FRAME; };
+    return { std::istreambuf_iterator<char>(dataFile), {} };
+};
+
+// prices of a tick in rupees, so expectations hold with fixed point prices too
+// (netChange is divided in a different order there, hence NET_CHANGE_ERROR)
+constexpr double NET_CHANGE_ERROR = 1e-12;
+
+double rupees(const kc::tick& Tick, kc::Price price) {
+    return kc::toDouble(price, Tick.instrumentToken);
+};
+
 TEST(tickerTest, binaryParsingTest) {
     kc::ticker Ticker("apikey123");
-    std::ifstream dataFile("../tests/mock_custom/websocket_ticks.bin");
-    ASSERT_TRUE(dataFile);
-    std::vector<char> data(std::istreambuf_iterator<char>(dataFile), {});
+    std::vector<char> data = loadTicksFrame();
 
     std::vector<kc::tick> ticks =
         Ticker.parseBinaryMessage(data.data(), data.size());
 
     ASSERT_EQ(ticks.size(), 2);
     kc::tick tick1 = ticks[0];
-    EXPECT_EQ(tick1.mode, "full");
+    EXPECT_EQ(tick1.mode, kc::TICK_MODE::FULL);
     EXPECT_EQ(tick1.instrumentToken, 408065);
     EXPECT_EQ(tick1.isTradable, true);
     EXPECT_EQ(tick1.timestamp, 1612777255);
     EXPECT_EQ(tick1.lastTradeTime, 1612777255);
-    EXPECT_DOUBLE_EQ(tick1.lastPrice, 1299.05);
+    EXPECT_DOUBLE_EQ(rupees(tick1, tick1.lastPrice), 1299.05);
     EXPECT_EQ(tick1.lastTradedQuantity, 2);
     EXPECT_EQ(tick1.totalBuyQuantity, 390117);
     EXPECT_EQ(tick1.totalSellQuantity, 410173);
     EXPECT_EQ(tick1.volumeTraded, 6065675);
-    EXPECT_DOUBLE_EQ(tick1.averageTradePrice, 1290.29);
+    EXPECT_DOUBLE_EQ(rupees(tick1, tick1.averageTradePrice), 1290.29);
     EXPECT_EQ(tick1.oi, 0);
     EXPECT_EQ(tick1.oiDayHigh, 0);
     EXPECT_EQ(tick1.oiDayLow, 0);
-    EXPECT_DOUBLE_EQ(tick1.netChange, 2.1185441396116693);
+    EXPECT_NEAR(tick1.netChange, 2.1185441396116693, NET_CHANGE_ERROR);
 
-    EXPECT_DOUBLE_EQ(tick1.ohlc.open, 1285.5);
-    EXPECT_DOUBLE_EQ(tick1.ohlc.high, 1305.90);
-    EXPECT_DOUBLE_EQ(tick1.ohlc.low, 1275.5);
-    EXPECT_DOUBLE_EQ(tick1.ohlc.close, 1272.1);
+    EXPECT_DOUBLE_EQ(rupees(tick1, tick1.ohlc.open), 1285.5);
+    EXPECT_DOUBLE_EQ(rupees(tick1, tick1.ohlc.high), 1305.90);
+    EXPECT_DOUBLE_EQ(rupees(tick1, tick1.ohlc.low), 1275.5);
+    EXPECT_DOUBLE_EQ(rupees(tick1, tick1.ohlc.close), 1272.1);
 
-    EXPECT_DOUBLE_EQ(tick1.marketDepth.buy[0].price, 1299);
+    EXPECT_EQ(tick1.marketDepth.count, 5);
+
+    EXPECT_DOUBLE_EQ(rupees(tick1, tick1.marketDepth.buy[0].price), 1299);
     EXPECT_EQ(tick1.marketDepth.buy[0].quantity, 2098);
     EXPECT_EQ(tick1.marketDepth.buy[0].orders, 10);
 
-    EXPECT_DOUBLE_EQ(tick1.marketDepth.buy[1].price, 1298.90);
+    EXPECT_DOUBLE_EQ(rupees(tick1, tick1.marketDepth.buy[1].price), 1298.90);
     EXPECT_EQ(tick1.marketDepth.buy[1].quantity, 6);
     EXPECT_EQ(tick1.marketDepth.buy[1].orders, 2);
 
-    EXPECT_DOUBLE_EQ(tick1.marketDepth.buy[2].price, 1298.8);
+    EXPECT_DOUBLE_EQ(rupees(tick1, tick1.marketDepth.buy[2].price), 1298.8);
     EXPECT_EQ(tick1.marketDepth.buy[2].quantity, 135);
     EXPECT_EQ(tick1.marketDepth.buy[2].orders, 5);
 
-    EXPECT_DOUBLE_EQ(tick1.marketDepth.buy[3].price, 1298.75);
+    EXPECT_DOUBLE_EQ(rupees(tick1, tick1.marketDepth.buy[3].price), 1298.75);
     EXPECT_EQ(tick1.marketDepth.buy[3].quantity, 1);
     EXPECT_EQ(tick1.marketDepth.buy[3].orders, 1);
 
-    EXPECT_DOUBLE_EQ(tick1.marketDepth.buy[4].price, 1298.7);
+    EXPECT_DOUBLE_EQ(rupees(tick1, tick1.marketDepth.buy[4].price), 1298.7);
     EXPECT_EQ(tick1.marketDepth.buy[4].quantity, 55);
     EXPECT_EQ(tick1.marketDepth.buy[4].orders, 2);
 
-    EXPECT_DOUBLE_EQ(tick1.marketDepth.sell[0].price, 1299.05);
+    EXPECT_DOUBLE_EQ(rupees(tick1, tick1.marketDepth.sell[0].price), 1299.05);
     EXPECT_EQ(tick1.marketDepth.sell[0].quantity, 335);
     EXPECT_EQ(tick1.marketDepth.sell[0].orders, 7);
 
-    EXPECT_DOUBLE_EQ(tick1.marketDepth.sell[1].price, 1299.1);
+    EXPECT_DOUBLE_EQ(rupees(tick1, tick1.marketDepth.sell[1].price), 1299.1);
     EXPECT_EQ(tick1.marketDepth.sell[1].quantity, 1);
     EXPECT_EQ(tick1.marketDepth.sell[1].orders, 1);
 
-    EXPECT_DOUBLE_EQ(tick1.marketDepth.sell[2].price, 1299.4);
+    EXPECT_DOUBLE_EQ(rupees(tick1, tick1.marketDepth.sell[2].price), 1299.4);
     EXPECT_EQ(tick1.marketDepth.sell[2].quantity, 45);
     EXPECT_EQ(tick1.marketDepth.sell[2].orders, 2);
 
-    EXPECT_DOUBLE_EQ(tick1.marketDepth.sell[3].price, 1299.45);
+    EXPECT_DOUBLE_EQ(rupees(tick1, tick1.marketDepth.sell[3].price), 1299.45);
     EXPECT_EQ(tick1.marketDepth.sell[3].quantity, 120);
     EXPECT_EQ(tick1.marketDepth.sell[3].orders, 2);
 
-    EXPECT_DOUBLE_EQ(tick1.marketDepth.sell[4].price, 1299.5);
+    EXPECT_DOUBLE_EQ(rupees(tick1, tick1.marketDepth.sell[4].price), 1299.5);
     EXPECT_EQ(tick1.marketDepth.sell[4].quantity, 233);
     EXPECT_EQ(tick1.marketDepth.sell[4].orders, 3);
 
     kc::tick tick2 = ticks[1];
-    EXPECT_EQ(tick2.mode, "full");
+    EXPECT_EQ(tick2.mode, kc::TICK_MODE::FULL);
     EXPECT_EQ(tick2.instrumentToken, 2953217);
     EXPECT_EQ(tick2.isTradable, true);
     EXPECT_EQ(tick2.timestamp, 1612777254);
     EXPECT_EQ(tick2.lastTradeTime, 1612777254);
-    EXPECT_DOUBLE_EQ(tick2.lastPrice, 3209.40);
+    EXPECT_DOUBLE_EQ(rupees(tick2, tick2.lastPrice), 3209.40);
     EXPECT_EQ(tick2.lastTradedQuantity, 148);
     EXPECT_EQ(tick2.totalBuyQuantity, 146646);
     EXPECT_EQ(tick2.totalSellQuantity, 145876);
     EXPECT_EQ(tick2.volumeTraded, 2261635);
-    EXPECT_DOUBLE_EQ(tick2.averageTradePrice, 3188.32);
+    EXPECT_DOUBLE_EQ(rupees(tick2, tick2.averageTradePrice), 3188.32);
     EXPECT_EQ(tick2.oi, 0);
     EXPECT_EQ(tick2.oiDayHigh, 0);
     EXPECT_EQ(tick2.oiDayLow, 0);
-    EXPECT_DOUBLE_EQ(tick2.netChange, 1.6292214886239578);
+    EXPECT_NEAR(tick2.netChange, 1.6292214886239578, NET_CHANGE_ERROR);
+
+    EXPECT_DOUBLE_EQ(rupees(tick2, tick2.ohlc.open), 3189.5);
+    EXPECT_DOUBLE_EQ(rupees(tick2, tick2.ohlc.high), 3226);
+    EXPECT_DOUBLE_EQ(rupees(tick2, tick2.ohlc.low), 3155.15);
+    EXPECT_DOUBLE_EQ(rupees(tick2, tick2.ohlc.close), 3157.95);
 
-    EXPECT_DOUBLE_EQ(tick2.ohlc.open, 3189.5);
-    EXPECT_DOUBLE_EQ(tick2.ohlc.high, 3226);
-    EXPECT_DOUBLE_EQ(tick2.ohlc.low, 3155.15);
-    EXPECT_DOUBLE_EQ(tick2.ohlc.close, 3157.95);
+    EXPECT_EQ(tick2.marketDepth.count, 5);
 
-    EXPECT_DOUBLE_EQ(tick2.marketDepth.buy[0].price, 3209.7);
+    EXPECT_DOUBLE_EQ(rupees(tick2, tick2.marketDepth.buy[0].price), 3209.7);
     EXPECT_EQ(tick2.marketDepth.buy[0].quantity, 1);
     EXPECT_EQ(tick2.marketDepth.buy[0].orders, 1);
 
-    EXPECT_DOUBLE_EQ(tick2.marketDepth.buy[1].price, 3209.4);
+    EXPECT_DOUBLE_EQ(rupees(tick2, tick2.marketDepth.buy[1].price), 3209.4);
     EXPECT_EQ(tick2.marketDepth.buy[1].quantity, 300);
     EXPECT_EQ(tick2.marketDepth.buy[1].orders, 1);
 
-    EXPECT_DOUBLE_EQ(tick2.marketDepth.buy[2].price, 3209.25);
+    EXPECT_DOUBLE_EQ(rupees(tick2, tick2.marketDepth.buy[2].price), 3209.25);
     EXPECT_EQ(tick2.marketDepth.buy[2].quantity, 138);
     EXPECT_EQ(tick2.marketDepth.buy[2].orders, 1);
 
-    EXPECT_DOUBLE_EQ(tick2.marketDepth.buy[3].price, 3209.15);
+    EXPECT_DOUBLE_EQ(rupees(tick2, tick2.marketDepth.buy[3].price), 3209.15);
     EXPECT_EQ(tick2.marketDepth.buy[3].quantity, 31);
     EXPECT_EQ(tick2.marketDepth.buy[3].orders, 1);
 
-    EXPECT_DOUBLE_EQ(tick2.marketDepth.buy[4].price, 3209.05);
+    EXPECT_DOUBLE_EQ(rupees(tick2, tick2.marketDepth.buy[4].price), 3209.05);
     EXPECT_EQ(tick2.marketDepth.buy[4].quantity, 52);
     EXPECT_EQ(tick2.marketDepth.buy[4].orders, 1);
 
-    EXPECT_DOUBLE_EQ(tick2.marketDepth.sell[0].price, 3209.95);
+    EXPECT_DOUBLE_EQ(rupees(tick2, tick2.marketDepth.sell[0].price), 3209.95);
     EXPECT_EQ(tick2.marketDepth.sell[0].quantity, 16);
     EXPECT_EQ(tick2.marketDepth.sell[0].orders, 2);
 
-    EXPECT_DOUBLE_EQ(tick2.marketDepth.sell[1].price, 3210.05);
+    EXPECT_DOUBLE_EQ(rupees(tick2, tick2.marketDepth.sell[1].price), 3210.05);
     EXPECT_EQ(tick2.marketDepth.sell[1].quantity, 35);
     EXPECT_EQ(tick2.marketDepth.sell[1].orders, 1);
 
-    EXPECT_DOUBLE_EQ(tick2.marketDepth.sell[2].price, 3210.1);
+    EXPECT_DOUBLE_EQ(rupees(tick2, tick2.marketDepth.sell[2].price), 3210.1);
     EXPECT_EQ(tick2.marketDepth.sell[2].quantity, 47);
     EXPECT_EQ(tick2.marketDepth.sell[2].orders, 2);
 
-    EXPECT_DOUBLE_EQ(tick2.marketDepth.sell[3].price, 3210.15);
+    EXPECT_DOUBLE_EQ(rupees(tick2, tick2.marketDepth.sell[3].price), 3210.15);
     EXPECT_EQ(tick2.marketDepth.sell[3].quantity, 30);
     EXPECT_EQ(tick2.marketDepth.sell[3].orders, 3);
 
-    EXPECT_DOUBLE_EQ(tick2.marketDepth.sell[4].price, 3210.2);
+    EXPECT_DOUBLE_EQ(rupees(tick2, tick2.marketDepth.sell[4].price), 3210.2);
     EXPECT_EQ(tick2.marketDepth.sell[4].quantity, 670);
     EXPECT_EQ(tick2.marketDepth.sell[4].orders, 1);
 };
+
+TEST(tickerTest, truncatedBinaryMessageTest) {
+    kc::ticker Ticker("apikey123");
+    std::vector<char> data = loadTicksFrame();
+
+    // header claims two packets but the second one is cut short
+    EXPECT_THROW(Ticker.parseBinaryMessage(data.data(), data.size() - 1),
+        kc::libException);
+    // a frame too small to hold the header doesn't have any packets
+    EXPECT_TRUE(Ticker.parseBinaryMessage(data.data(), 1).empty());
+};
+
+TEST(tickerTest, tickBufferReuseTest) {
+    kc::ticker Ticker("apikey123");
+    std::vector<char> data = loadTicksFrame();
+
+    std::vector<kc::tick> buffer;
+    Ticker.parseBinaryMessage(data.data(), data.size(), buffer);
+    ASSERT_EQ(buffer.size(), 2);
+    const kc::tick* storage = buffer.data();
+
+    // decoding another frame reuses the storage instead of reallocating
+    Ticker.parseBinaryMessage(data.data(), data.size(), buffer);
+    ASSERT_EQ(buffer.size(), 2);
+    EXPECT_EQ(buffer.data(), storage);
+    EXPECT_EQ(buffer[1].instrumentToken, 2953217);
+};
+
+TEST(tickerTest, tickViewTest) {
+    kc::ticker Ticker("apikey123");
+    std::vector<char> data = loadTicksFrame();
+
+    std::vector<kc::tickView> views;
+    Ticker.splitPackets(
+        data.data(), data.size(), [&](const char* packet, size_t size) {
+            views.emplace_back(packet, size);
+        });
+    const std::vector<kc::tick> ticks =
+        Ticker.parseBinaryMessage(data.data(), data.size());
+    ASSERT_EQ(views.size(), ticks.size());
+
+    for (size_t i = 0; i < views.size(); i++) {
+        const kc::tickView& view = views[i];
+        const kc::tick& tick = ticks[i];
+        EXPECT_EQ(view.mode(), tick.mode);
+        EXPECT_EQ(view.instrumentToken(), tick.instrumentToken);
+        EXPECT_EQ(view.isTradable(), tick.isTradable);
+        EXPECT_EQ(view.timestamp(), tick.timestamp);
+        EXPECT_EQ(view.lastTradeTime(), tick.lastTradeTime);
+        EXPECT_DOUBLE_EQ(view.lastPrice(), tick.lastPrice);
+        EXPECT_EQ(view.lastTradedQuantity(), tick.lastTradedQuantity);
+        EXPECT_EQ(view.totalBuyQuantity(), tick.totalBuyQuantity);
+        EXPECT_EQ(view.totalSellQuantity(), tick.totalSellQuantity);
+        EXPECT_EQ(view.volumeTraded(), tick.volumeTraded);
+        EXPECT_DOUBLE_EQ(view.averageTradePrice(), tick.averageTradePrice);
+        EXPECT_EQ(view.oi(), tick.oi);
+        EXPECT_EQ(view.oiDayHigh(), tick.oiDayHigh);
+        EXPECT_EQ(view.oiDayLow(), tick.oiDayLow);
+        EXPECT_DOUBLE_EQ(view.netChange(), tick.netChange);
+        EXPECT_DOUBLE_EQ(view.ohlc().open, tick.ohlc.open);
+        EXPECT_DOUBLE_EQ(view.ohlc().high, tick.ohlc.high);
+        EXPECT_DOUBLE_EQ(view.ohlc().low, tick.ohlc.low);
+        EXPECT_DOUBLE_EQ(view.ohlc().close, tick.ohlc.close);
+        for (size_t level = 0; level < kc::tick::DEPTH_LEVELS; level++) {
+            EXPECT_DOUBLE_EQ(
+                view.buy(level).price, tick.marketDepth.buy[level].price);
+            EXPECT_EQ(
+                view.buy(level).quantity, tick.marketDepth.buy[level].quantity);
+            EXPECT_EQ(
+                view.buy(level).orders, tick.marketDepth.buy[level].orders);
+            EXPECT_DOUBLE_EQ(
+                view.sell(level).price, tick.marketDepth.sell[level].price);
+            EXPECT_EQ(view.sell(level).quantity,
+                tick.marketDepth.sell[level].quantity);
+            EXPECT_EQ(
+                view.sell(level).orders, tick.marketDepth.sell[level].orders);
+        };
+    };
+
+    // fields that aren't part of a LTP packet aren't decoded
+    const kc::tickView ltp(data.data() + 4, 8);
+    EXPECT_EQ(ltp.mode(), kc::TICK_MODE::LTP);
+    EXPECT_EQ(ltp.instrumentToken(), 408065);
+    EXPECT_DOUBLE_EQ(kc::toDouble(ltp.lastPrice(), 408065), 1299.05);
+    EXPECT_EQ(ltp.volumeTraded(), -1);
+    EXPECT_EQ(ltp.buy(0).quantity, -1);
+};
+
+TEST(tickerTest, tickBatchTest) {
+    kc::ticker Ticker("apikey123");
+    std::vector<char> data = loadTicksFrame();
+
+    kc::tickBatch batch;
+    Ticker.parseBinaryMessage(data.data(), data.size(), batch);
+    const std::vector<kc::tick> ticks =
+        Ticker.parseBinaryMessage(data.data(), data.size());
+    ASSERT_EQ(batch.size(), ticks.size());
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(batch.lastPrice.data()) %
+                  kc::tickBatch::ALIGNMENT,
+        0);
+
+    for (size_t i = 0; i < batch.size(); i++) {
+        const kc::tick& tick = ticks[i];
+        EXPECT_EQ(batch.mode[i], tick.mode);
+        EXPECT_EQ(batch.instrumentToken[i], tick.instrumentToken);
+        EXPECT_EQ(batch.isTradable[i] != 0, tick.isTradable);
+        EXPECT_EQ(batch.timestamp[i], tick.timestamp);
+        EXPECT_EQ(batch.lastTradeTime[i], tick.lastTradeTime);
+        EXPECT_DOUBLE_EQ(batch.lastPrice[i], tick.lastPrice);
+        EXPECT_EQ(batch.lastTradedQuantity[i], tick.lastTradedQuantity);
+        EXPECT_EQ(batch.totalBuyQuantity[i], tick.totalBuyQuantity);
+        EXPECT_EQ(batch.totalSellQuantity[i], tick.totalSellQuantity);
+        EXPECT_EQ(batch.volumeTraded[i], tick.volumeTraded);
+        EXPECT_DOUBLE_EQ(batch.averageTradePrice[i], tick.averageTradePrice);
+        EXPECT_EQ(batch.oi[i], tick.oi);
+        EXPECT_EQ(batch.oiDayHigh[i], tick.oiDayHigh);
+        EXPECT_EQ(batch.oiDayLow[i], tick.oiDayLow);
+        EXPECT_DOUBLE_EQ(batch.netChange[i], tick.netChange);
+        EXPECT_DOUBLE_EQ(batch.open[i], tick.ohlc.open);
+        EXPECT_DOUBLE_EQ(batch.high[i], tick.ohlc.high);
+        EXPECT_DOUBLE_EQ(batch.low[i], tick.ohlc.low);
+        EXPECT_DOUBLE_EQ(batch.close[i], tick.ohlc.close);
+        EXPECT_DOUBLE_EQ(batch.bidPrice[i], tick.marketDepth.buy[0].price);
+        EXPECT_EQ(batch.bidQuantity[i], tick.marketDepth.buy[0].quantity);
+        EXPECT_DOUBLE_EQ(batch.askPrice[i], tick.marketDepth.sell[0].price);
+        EXPECT_EQ(batch.askQuantity[i], tick.marketDepth.sell[0].quantity);
+    };
+
+    // reused batches are resized to the frame rather than appended to
+    Ticker.parseBinaryMessage(data.data(), data.size(), batch);
+    EXPECT_EQ(batch.size(), ticks.size());
+};
+
+// compares fields rather than bytes, padding of a decoded tick is unspecified
+void expectSameTick(const kc::tick& actual, const kc::tick& expected) {
+    EXPECT_EQ(actual.instrumentToken, expected.instrumentToken);
+    EXPECT_EQ(actual.mode, expected.mode);
+    EXPECT_EQ(actual.lastPrice, expected.lastPrice);
+    EXPECT_EQ(actual.volumeTraded, expected.volumeTraded);
+    EXPECT_EQ(actual.timestamp, expected.timestamp);
+    EXPECT_EQ(actual.ohlc.close, expected.ohlc.close);
+    EXPECT_EQ(actual.marketDepth.count, expected.marketDepth.count);
+    EXPECT_EQ(actual.marketDepth.sell.back().price,
+        expected.marketDepth.sell.back().price);
+};
+
+TEST(tickerTest, snapshotTest) {
+    kc::ticker Ticker("apikey123");
+    std::vector<char> data = loadTicksFrame();
+    const std::vector<kc::tick> ticks =
+        Ticker.parseBinaryMessage(data.data(), data.size());
+
+    kc::tick Tick;
+    EXPECT_FALSE(Ticker.getLatestTick(ticks[0].instrumentToken, Tick));
+    Ticker.enableSnapshots(16);
+    Ticker.processBinaryMessage(data.data(), data.size());
+    for (const kc::tick& expected : ticks) {
+        ASSERT_TRUE(Ticker.getLatestTick(expected.instrumentToken, Tick));
+        expectSameTick(Tick, expected);
+    };
+    EXPECT_FALSE(Ticker.getLatestTick(1, Tick));
+
+    // a store that's full keeps its instruments but rejects new ones
+    kc::tickSnapshots full(1);
+    kc::tick first;
+    first.instrumentToken = 1;
+    kc::tick second;
+    second.instrumentToken = 2;
+    EXPECT_TRUE(full.store(first));
+    EXPECT_FALSE(full.store(second));
+    EXPECT_TRUE(full.store(first));
+    EXPECT_EQ(full.size(), 1);
+
+    // readers never see a partially written tick
+    constexpr int32_t TOKEN = 408065;
+    constexpr int WRITES = 200000;
+    kc::tickSnapshots store(4);
+    std::atomic<bool> done { false };
+    std::thread writer([&]() {
+        kc::tick Update;
+        Update.instrumentToken = TOKEN;
+        for (int i = 0; i < WRITES; i++) {
+            Update.volumeTraded = i;
+            Update.oi = i;
+            Update.marketDepth.sell.back().quantity = i;
+            store.store(Update);
+        };
+        done = true;
+    });
+    int32_t last = -1;
+    bool consistent = true;
+    while (!done && consistent) {
+        kc::tick Read;
+        if (!store.load(TOKEN, Read)) { continue; };
+        consistent = Read.volumeTraded == Read.oi &&
+                     Read.volumeTraded ==
+                         Read.marketDepth.sell.back().quantity &&
+                     Read.volumeTraded >= last;
+        last = Read.volumeTraded;
+    };
+    writer.join();
+    EXPECT_TRUE(consistent);
+};
+
+TEST(tickerTest, tickQueueTest) {
+    kc::ticker Ticker("apikey123");
+    std::vector<char> data = loadTicksFrame();
+    const std::vector<kc::tick> ticks =
+        Ticker.parseBinaryMessage(data.data(), data.size());
+
+    kc::tickQueue queue(64);
+    Ticker.addTickQueue(&queue);
+    Ticker.processBinaryMessage(data.data(), data.size());
+    EXPECT_EQ(queue.size(), ticks.size());
+    kc::tick Tick;
+    for (const kc::tick& expected : ticks) {
+        ASSERT_TRUE(queue.pop(Tick));
+        expectSameTick(Tick, expected);
+    };
+    EXPECT_FALSE(queue.pop(Tick));
+    Ticker.removeTickQueue(&queue);
+    Ticker.processBinaryMessage(data.data(), data.size());
+    EXPECT_EQ(queue.size(), 0);
+
+    const auto tickOf = [](int32_t token, int32_t volume) {
+        kc::tick Tick;
+        Tick.instrumentToken = token;
+        Tick.volumeTraded = volume;
+        return Tick;
+    };
+
+    kc::tickQueue dropOldest(2, kc::OVERFLOW_POLICY::DROP_OLDEST);
+    for (int32_t i = 1; i <= 5; i++) {
+        EXPECT_TRUE(dropOldest.push(tickOf(i, i)));
+    };
+    EXPECT_EQ(dropOldest.size(), 2);
+    EXPECT_EQ(dropOldest.dropped(), 3);
+    ASSERT_TRUE(dropOldest.pop(Tick));
+    EXPECT_EQ(Tick.instrumentToken, 4);
+    ASSERT_TRUE(dropOldest.pop(Tick));
+    EXPECT_EQ(Tick.instrumentToken, 5);
+
+    kc::tickQueue conflate(4, kc::OVERFLOW_POLICY::CONFLATE);
+    EXPECT_TRUE(conflate.push(tickOf(1, 1)));
+    EXPECT_TRUE(conflate.push(tickOf(2, 1)));
+    EXPECT_TRUE(conflate.push(tickOf(1, 2)));
+    EXPECT_EQ(conflate.size(), 2);
+    EXPECT_EQ(conflate.dropped(), 1);
+    ASSERT_TRUE(conflate.pop(Tick));
+    EXPECT_EQ(Tick.instrumentToken, 1);
+    EXPECT_EQ(Tick.volumeTraded, 2);
+    ASSERT_TRUE(conflate.pop(Tick));
+    EXPECT_EQ(Tick.instrumentToken, 2);
+    EXPECT_FALSE(conflate.pop(Tick));
+    EXPECT_TRUE(conflate.push(tickOf(1, 3)));
+    EXPECT_EQ(conflate.size(), 1);
+
+    kc::tickQueue block(2, kc::OVERFLOW_POLICY::BLOCK);
+    EXPECT_TRUE(block.push(tickOf(1, 1)));
+    EXPECT_TRUE(block.push(tickOf(2, 1)));
+    block.close();
+    EXPECT_FALSE(block.push(tickOf(3, 1)));
+    EXPECT_EQ(block.dropped(), 1);
+
+    // the consumer only ever sees whole ticks, in order
+    constexpr int32_t WRITES = 200000;
+    kc::tickQueue threaded(8, kc::OVERFLOW_POLICY::DROP_OLDEST);
+    std::atomic<bool> done { false };
+    std::thread producer([&]() {
+        kc::tick Update = tickOf(408065, 0);
+        for (int32_t i = 0; i < WRITES; i++) {
+            Update.volumeTraded = i;
+            Update.marketDepth.sell.back().quantity = i;
+            threaded.push(Update);
+        };
+        done = true;
+    });
+    int32_t last = -1;
+    uint64_t popped = 0;
+    bool consistent = true;
+    while (consistent && (!done || threaded.size() > 0)) {
+        kc::tick Read;
+        if (!threaded.pop(Read)) { continue; };
+        popped++;
+        consistent =
+            Read.volumeTraded == Read.marketDepth.sell.back().quantity &&
+            Read.volumeTraded > last;
+        last = Read.volumeTraded;
+    };
+    producer.join();
+    EXPECT_TRUE(consistent);
+    EXPECT_EQ(popped + threaded.dropped() + threaded.size(),
+        static_cast<uint64_t>(WRITES));
+};
+
+TEST(tickerTest, shardedTickerTest) {
+    kc::shardedTicker Ticker("apikey123", 2);
+    std::vector<int> instruments(5000);
+    for (size_t i = 0; i < instruments.size(); i++) {
+        instruments[i] = static_cast<int>(i + 1);
+    };
+
+    // instruments can be subscribed before connecting
+    Ticker.subscribe(instruments);
+    EXPECT_EQ(Ticker.instrumentCount(0), 2500);
+    EXPECT_EQ(Ticker.instrumentCount(1), 2500);
+    std::vector<int> tooMany(1001);
+    for (size_t i = 0; i < tooMany.size(); i++) {
+        tooMany[i] = static_cast<int>(i + 10000);
+    };
+    EXPECT_THROW(Ticker.subscribe(tooMany), kc::libException);
+    EXPECT_EQ(Ticker.instrumentCount(0) + Ticker.instrumentCount(1), 5000);
+    Ticker.subscribe(instruments);
+    EXPECT_EQ(Ticker.instrumentCount(0) + Ticker.instrumentCount(1), 5000);
+
+    // unsubscribing a shard's instruments moves others over from the rest
+    std::vector<int> firstShard;
+    for (const int tok : instruments) {
+        if (Ticker.shardOf(tok) == 0U) { firstShard.push_back(tok); };
+    };
+    Ticker.setMode(kc::MODE_FULL, { firstShard.back() });
+    Ticker.unsubscribe(
+        std::vector<int>(firstShard.begin(), firstShard.begin() + 1000));
+    EXPECT_EQ(Ticker.instrumentCount(0), 2000);
+    EXPECT_EQ(Ticker.instrumentCount(1), 2000);
+    EXPECT_FALSE(Ticker.shardOf(firstShard.front()).has_value());
+    for (const int tok : instruments) {
+        const auto shard = Ticker.shardOf(tok);
+        if (!shard.has_value()) { continue; };
+        EXPECT_EQ(Ticker.shard(*shard).subbedInstruments.count(tok), 1);
+    };
+    const size_t lastShard = *Ticker.shardOf(firstShard.back());
+    EXPECT_EQ(Ticker.shard(lastShard).subbedInstruments.at(firstShard.back()),
+        kc::ticker::MODES::FULL);
+
+    // ticks of every shard go to the same callback
+    std::vector<char> data = loadTicksFrame();
+    size_t received = 0;
+    Ticker.onTicks = [&](kc::shardedTicker* ws,
+                         const std::vector<kc::tick>& ticks) {
+        EXPECT_EQ(ws, &Ticker);
+        received += ticks.size();
+    };
+    Ticker.connect();
+    Ticker.shard(0).processBinaryMessage(data.data(), data.size());
+    Ticker.shard(1).processBinaryMessage(data.data(), data.size());
+    const std::vector<kc::tick> ticks =
+        Ticker.shard(0).parseBinaryMessage(data.data(), data.size());
+    EXPECT_EQ(received, 2 * ticks.size());
+};
+
+TEST(tickerTest, conflationTest) {
+    kc::ticker Ticker("apikey123");
+    std::vector<char> data = loadTicksFrame();
+    const std::vector<kc::tick> ticks =
+        Ticker.parseBinaryMessage(data.data(), data.size());
+
+    size_t calls = 0;
+    std::vector<kc::tick> delivered;
+    Ticker.onTicks = [&](kc::ticker* /*ws*/,
+                         const std::vector<kc::tick>& Ticks) {
+        calls++;
+        delivered = Ticks;
+    };
+    // an interval of 0 would flush only once
+    EXPECT_THROW(Ticker.enableConflation(0), kc::libException);
+    EXPECT_FALSE(Ticker.conflationTimer.isActive());
+
+    // the flush timer is driven by the event loop, flushes are made by hand
+    Ticker.enableConflation(1000);
+    Ticker.processBinaryMessage(data.data(), data.size());
+    Ticker.processBinaryMessage(data.data(), data.size());
+    EXPECT_EQ(calls, 0);
+    EXPECT_EQ(Ticker.getMergedTickCount(), ticks.size());
+
+    Ticker.flushConflated();
+    EXPECT_EQ(calls, 1);
+    ASSERT_EQ(delivered.size(), ticks.size());
+    for (size_t i = 0; i < ticks.size(); i++) {
+        expectSameTick(delivered[i], ticks[i]);
+    };
+    Ticker.flushConflated();
+    EXPECT_EQ(calls, 1);
+
+    // instruments seen before a delivery aren't merged into the next one
+    Ticker.processBinaryMessage(data.data(), data.size());
+    EXPECT_EQ(Ticker.getMergedTickCount(), ticks.size());
+    Ticker.disableConflation();
+    EXPECT_EQ(calls, 2);
+    EXPECT_EQ(delivered.size(), ticks.size());
+    Ticker.processBinaryMessage(data.data(), data.size());
+    EXPECT_EQ(calls, 3);
+};
+
+TEST(tickerTest, tickFilterTest) {
+    kc::ticker Ticker("apikey123");
+    const std::vector<char> data = loadTicksFrame();
+    std::vector<size_t> offsets;
+    std::vector<size_t> sizes;
+    Ticker.splitPackets(
+        data.data(), data.size(), [&](const char* packet, size_t size) {
+            offsets.push_back(static_cast<size_t>(packet - data.data()));
+            sizes.push_back(size);
+        });
+    ASSERT_GE(offsets.size(), 2);
+
+    std::vector<kc::tick> delivered;
+    Ticker.onTicks = [&](kc::ticker* /*ws*/,
+                         const std::vector<kc::tick>& ticks) {
+        delivered = ticks;
+    };
+    // frames are compacted in place, so every call gets a fresh copy
+    const auto process = [&](std::vector<char> frame) {
+        delivered.clear();
+        Ticker.processBinaryMessage(frame.data(), frame.size());
+        return delivered.size();
+    };
+    const auto changed = [&](size_t packet, size_t field) {
+        std::vector<char> frame = data;
+        frame[offsets[packet] + field]++;
+        return frame;
+    };
+    const auto fullPacket = static_cast<size_t>(
+        std::find(sizes.begin(), sizes.end(), 184) - sizes.begin());
+    ASSERT_LT(fullPacket, sizes.size());
+    constexpr size_t TIMESTAMP = 63;
+    constexpr size_t BEST_BID_QUANTITY = 67;
+    constexpr size_t THIRD_BID_QUANTITY = 91;
+
+    Ticker.setTickFilter(kc::TICK_FILTER::TOP_OF_BOOK);
+    EXPECT_EQ(process(data), offsets.size());
+    EXPECT_EQ(process(data), 0);
+    EXPECT_EQ(Ticker.getSuppressedTickCount(), offsets.size());
+    EXPECT_EQ(process(changed(fullPacket, TIMESTAMP)), 0);
+    EXPECT_EQ(process(changed(fullPacket, THIRD_BID_QUANTITY)), 0);
+    ASSERT_EQ(process(changed(fullPacket, BEST_BID_QUANTITY)), 1);
+    EXPECT_EQ(delivered[0].marketDepth.buy[0].quantity,
+        Ticker.parsePacket(&data[offsets[fullPacket]], 184)
+                .marketDepth.buy[0]
+                .quantity +
+            1);
+
+    Ticker.setTickFilter(kc::TICK_FILTER::FULL_DEPTH);
+    EXPECT_EQ(process(data), offsets.size());
+    EXPECT_EQ(process(changed(fullPacket, TIMESTAMP)), 0);
+    EXPECT_EQ(process(changed(fullPacket, THIRD_BID_QUANTITY)), 1);
+
+    Ticker.setTickFilter(kc::TICK_FILTER::LTP);
+    EXPECT_EQ(process(data), offsets.size());
+    EXPECT_EQ(process(changed(1, kc::internal::packet::LAST_PRICE + 3)), 1);
+    EXPECT_EQ(delivered[0].instrumentToken,
+        Ticker.parsePacket(&data[offsets[1]], sizes[1]).instrumentToken);
+
+    Ticker.setTickFilter(kc::TICK_FILTER::NONE);
+    EXPECT_EQ(process(data), offsets.size());
+    EXPECT_EQ(process(data), offsets.size());
+};
+
+#ifndef KITE_DISABLE_JOURNAL
+TEST(tickerTest, journalTest) {
+    const std::vector<char> data = loadTicksFrame();
+    const string text = R"({"type":"order","data":{}})";
+    const string prefix = testing::TempDir() + "kitepp_journal_test";
+    constexpr size_t SEGMENT_SIZE = 4096;
+    constexpr size_t FRAMES = 25;
+    constexpr uint8_t BINARY = 2;
+    constexpr uint8_t TEXT = 1;
+
+    {
+        kc::tickJournal journal(prefix, SEGMENT_SIZE, 1);
+        for (size_t i = 0; i < FRAMES; i++) {
+            ASSERT_TRUE(journal.append(
+                BINARY, data.data(), data.size(), kc::tickJournal::now()));
+            ASSERT_TRUE(journal.append(
+                TEXT, text.data(), text.size(), kc::tickJournal::now()));
+        };
+        const std::vector<char> tooLarge(SEGMENT_SIZE);
+        EXPECT_FALSE(journal.append(
+            BINARY, tooLarge.data(), tooLarge.size(), kc::tickJournal::now()));
+        EXPECT_EQ(journal.recordCount(), FRAMES * 2);
+        EXPECT_EQ(journal.droppedCount(), 1);
+    };
+
+    size_t frames = 0;
+    uint64_t lastReceiveTime = 0;
+    bool matches = true;
+    const uint64_t segments = kc::tickJournal::read(prefix,
+        [&](const kc::tickJournal::recordHeader& header, const char* payload) {
+            const bool binary = (frames % 2 == 0);
+            const std::vector<char> expected = binary
+                ? data
+                : std::vector<char>(text.begin(), text.end());
+            matches = matches && header.opCode == (binary ? BINARY : TEXT) &&
+                      header.receiveTime >= lastReceiveTime &&
+                      std::equal(expected.begin(), expected.end(), payload,
+                          payload + header.length);
+            lastReceiveTime = header.receiveTime;
+            frames++;
+        });
+    EXPECT_TRUE(matches);
+    EXPECT_EQ(frames, FRAMES * 2);
+    EXPECT_GT(segments, 1);
+    for (uint64_t i = 0; i <= segments; i++) {
+        std::remove(kc::tickJournal::segmentPath(prefix, i).c_str());
+    };
+
+    kc::ticker Ticker("apikey123");
+    EXPECT_EQ(Ticker.getJournal(), nullptr);
+    Ticker.enableJournal(prefix, SEGMENT_SIZE);
+    ASSERT_NE(Ticker.getJournal(), nullptr);
+    Ticker.disableJournal();
+    EXPECT_EQ(Ticker.getJournal(), nullptr);
+    std::remove(kc::tickJournal::segmentPath(prefix, 0).c_str());
+    std::remove(kc::tickJournal::segmentPath(prefix, 1).c_str());
+};
+#endif
+
+TEST(tickerTest, replayTest) {
+    kc::ticker Ticker("apikey123");
+    size_t ticks = 0;
+    size_t messages = 0;
+    Ticker.onTicks = [&](kc::ticker* /*ws*/,
+                         const std::vector<kc::tick>& Ticks) {
+        ticks += Ticks.size();
+    };
+    Ticker.onMessage = [&](kc::ticker* /*ws*/, const string& /*message*/) {
+        messages++;
+    };
+
+    kc::tickReplay replay(Ticker);
+    replay.loadFrame(TICKS_FRAME);
+    const string text = R"({"type":"message","data":"hello"})";
+    replay.addFrame(static_cast<uint8_t>(uWS::OpCode::TEXT), text.data(),
+        text.size());
+    ASSERT_EQ(replay.frameCount(), 2);
+
+    constexpr size_t REPEAT = 100;
+    const kc::tickReplay::stats maxSpeed =
+        replay.run(kc::tickReplay::MAX_SPEED, REPEAT);
+    EXPECT_EQ(maxSpeed.frames, 2 * REPEAT);
+    EXPECT_EQ(maxSpeed.ticks, ticks);
+    EXPECT_GT(ticks, 0);
+    EXPECT_EQ(messages, REPEAT);
+    EXPECT_GT(maxSpeed.framesPerSecond(), 0);
+    EXPECT_GT(maxSpeed.ticksPerSecond(), 0);
+
+    // recorded 20ms apart
+    constexpr uint64_t GAP = 20'000'000;
+    replay.clear();
+    const std::vector<char> frame = { 0, 0 };
+    replay.addFrame(static_cast<uint8_t>(uWS::OpCode::BINARY), frame.data(),
+        frame.size(), GAP);
+    replay.addFrame(static_cast<uint8_t>(uWS::OpCode::BINARY), frame.data(),
+        frame.size(), 2 * GAP);
+    EXPECT_GE(replay.run(1).elapsed, std::chrono::nanoseconds(GAP));
+    const kc::tickReplay::stats fast = replay.run(4);
+    EXPECT_GE(fast.elapsed, std::chrono::nanoseconds(GAP / 4));
+    EXPECT_LT(fast.elapsed, std::chrono::nanoseconds(GAP));
+
+#ifndef KITE_DISABLE_JOURNAL
+    // frames recorded to a journal replay the same
+    const string prefix = testing::TempDir() + "kitepp_replay_test";
+    {
+        kc::tickJournal journal(prefix, kc::tickJournal::DEFAULT_SEGMENT_SIZE);
+        replay.clear();
+        replay.loadFrame(TICKS_FRAME);
+        const std::vector<char> data = loadTicksFrame();
+        journal.append(static_cast<uint8_t>(uWS::OpCode::BINARY), data.data(),
+            data.size(), kc::tickJournal::now());
+    };
+    kc::tickReplay journalReplay(Ticker);
+    EXPECT_EQ(journalReplay.loadJournal(prefix), 1);
+    EXPECT_EQ(journalReplay.run().ticks, replay.run().ticks);
+    std::remove(kc::tickJournal::segmentPath(prefix, 0).c_str());
+    std::remove(kc::tickJournal::segmentPath(prefix, 1).c_str());
+#endif
+};
+
+TEST(tickerTest, candleTest) {
+    constexpr int32_t TOKEN = 408065;
+    // 2023-11-15T03:43:00+0530
+    constexpr int32_t MINUTE = 1699999980;
+    const auto makeTick = [&](int32_t time, double price, int32_t volume) {
+        kc::tick Tick;
+        Tick.instrumentToken = TOKEN;
+        Tick.lastTradeTime = time;
+        Tick.lastPrice = kc::toPrice(price, TOKEN);
+        Tick.volumeTraded = volume;
+        return Tick;
+    };
+
+    kc::candleAggregator aggregator(60, 10, 2);
+    std::vector<kc::historicalData> closed;
+    aggregator.onCandle = [&](kc::candleAggregator* /*aggregator*/,
+                              int32_t instrumentToken,
+                              const kc::historicalData& candle) {
+        EXPECT_EQ(instrumentToken, TOKEN);
+        closed.push_back(candle);
+    };
+
+    aggregator.update({ makeTick(MINUTE + 1, 100, 1000),
+        makeTick(MINUTE + 10, 102.5, 1200), makeTick(MINUTE + 20, 99, 1250),
+        makeTick(MINUTE + 59, 101, 1300) });
+    kc::historicalData open;
+    ASSERT_TRUE(aggregator.getOpenCandle(TOKEN, open));
+    EXPECT_TRUE(closed.empty());
+
+    // a tick of the next minute closes the candle
+    aggregator.update(makeTick(MINUTE + 61, 103, 1400));
+    ASSERT_EQ(closed.size(), 1);
+    EXPECT_EQ(closed[0].datetime, "2023-11-15T03:43:00+0530");
+    EXPECT_DOUBLE_EQ(closed[0].open, 100);
+    EXPECT_DOUBLE_EQ(closed[0].high, 102.5);
+    EXPECT_DOUBLE_EQ(closed[0].low, 99);
+    EXPECT_DOUBLE_EQ(closed[0].close, 101);
+    EXPECT_EQ(closed[0].volume, 300);
+
+    // the timer closes a candle once its grace delay has elapsed too, trades
+    // arriving in between are still added to it
+    aggregator.close(MINUTE + 121);
+    EXPECT_EQ(closed.size(), 1);
+    aggregator.update(makeTick(MINUTE + 119, 105, 1420));
+    aggregator.close(MINUTE + 122);
+    ASSERT_EQ(closed.size(), 2);
+    EXPECT_EQ(closed[1].datetime, "2023-11-15T03:44:00+0530");
+    EXPECT_DOUBLE_EQ(closed[1].close, 105);
+    EXPECT_EQ(closed[1].volume, 120);
+    EXPECT_FALSE(aggregator.getOpenCandle(TOKEN, open));
+
+    // late trades are dropped with their volume
+    aggregator.update(makeTick(MINUTE + 90, 50, 1450));
+    EXPECT_EQ(aggregator.getLateTickCount(), 1);
+    aggregator.update(makeTick(MINUTE + 130, 104, 1500));
+
+    // quote updates carry the time of an earlier trade, they aren't late and
+    // only close the candle once their exchange time passes its end
+    kc::tick quote = makeTick(MINUTE + 90, 104, 1500);
+    quote.timestamp = MINUTE + 150;
+    aggregator.update(quote);
+    EXPECT_EQ(aggregator.getLateTickCount(), 1);
+    EXPECT_EQ(closed.size(), 2);
+    quote.timestamp = MINUTE + 180;
+    aggregator.update(quote);
+    ASSERT_EQ(closed.size(), 3);
+    EXPECT_DOUBLE_EQ(closed[2].low, 104);
+    EXPECT_EQ(closed[2].volume, 50);
+    EXPECT_FALSE(aggregator.getOpenCandle(TOKEN, open));
+
+    // only the last 2 candles are kept
+    std::vector<kc::historicalData> candles;
+    ASSERT_TRUE(aggregator.getCandles(TOKEN, candles));
+    ASSERT_EQ(candles.size(), 2);
+    EXPECT_EQ(candles[0].datetime, closed[1].datetime);
+    EXPECT_EQ(candles[1].datetime, closed[2].datetime);
+    EXPECT_FALSE(aggregator.getCandles(TOKEN + 1, candles));
+
+    // ticks without an exchange time are dropped instead of being bucketed
+    // by the local clock
+    kc::tick ltp;
+    ltp.instrumentToken = TOKEN + 1;
+    ltp.lastPrice = kc::toPrice(100, TOKEN + 1);
+    aggregator.update(ltp);
+    EXPECT_FALSE(aggregator.getOpenCandle(TOKEN + 1, open));
+
+    // hourly candles start at 09:15 IST like historical data
+    constexpr int32_t SESSION_START = MINUTE - 13380 + 33300;
+    kc::candleAggregator hourly(3600, 10, 2);
+    std::vector<kc::historicalData> hours;
+    hourly.onCandle = [&](kc::candleAggregator* /*aggregator*/,
+                          int32_t /*instrumentToken*/,
+                          const kc::historicalData& candle) {
+        hours.push_back(candle);
+    };
+    hourly.update({ makeTick(SESSION_START + 1800, 100, 1000),
+        makeTick(SESSION_START + 3599, 101, 1100) });
+    EXPECT_TRUE(hours.empty());
+    hourly.update(makeTick(SESSION_START + 3600, 102, 1200));
+    ASSERT_EQ(hours.size(), 1);
+    EXPECT_EQ(hours[0].datetime, "2023-11-15T09:15:00+0530");
+    EXPECT_DOUBLE_EQ(hours[0].close, 101);
+
+    kc::ticker Ticker("apikey123");
+    aggregator.start(Ticker);
+    aggregator.stop();
+};
+
+TEST(tickerTest, depthBookTest) {
+    constexpr int32_t TOKEN = 408065;
+    const auto price = [&](double value) { return kc::toPrice(value, TOKEN); };
+    kc::tick Tick;
+    Tick.instrumentToken = TOKEN;
+    Tick.marketDepth.count = 2;
+    Tick.marketDepth.buy[0] = { price(100), 10, 1 };
+    Tick.marketDepth.buy[1] = { price(99.5), 20, 2 };
+    Tick.marketDepth.sell[0] = { price(100.5), 30, 3 };
+    Tick.marketDepth.sell[1] = { price(0), 0, 0 };
+
+    kc::depthBook book;
+    std::vector<kc::depthChange> changes;
+    book.onChanges = [&](kc::depthBook* /*book*/,
+                         const std::vector<kc::depthChange>& Changes) {
+        changes = Changes;
+    };
+    book.update(Tick);
+    ASSERT_EQ(changes.size(), 3);
+    EXPECT_TRUE(std::all_of(changes.begin(), changes.end(),
+        [](const kc::depthChange& change) {
+            return change.change == kc::DEPTH_CHANGE::ADDED;
+        }));
+
+    kc::topOfBook top;
+    ASSERT_TRUE(book.getTopOfBook(TOKEN, top));
+    EXPECT_EQ(top.bidPrice, price(100));
+    EXPECT_EQ(top.askPrice, price(100.5));
+    EXPECT_EQ(top.spread, price(0.5));
+    EXPECT_DOUBLE_EQ(top.mid, 100.25);
+    EXPECT_DOUBLE_EQ(top.imbalance, -0.5);
+    EXPECT_EQ(top.bidDepth, 30);
+    EXPECT_EQ(top.askDepth, 30);
+
+    // best bid is taken out, the next one grows and a new ask is added
+    changes.clear();
+    Tick.marketDepth.buy[0] = { price(99.5), 25, 3 };
+    Tick.marketDepth.buy[1] = { price(0), 0, 0 };
+    Tick.marketDepth.sell[1] = { price(101), 5, 1 };
+    book.update(std::vector<kc::tick> { Tick });
+    ASSERT_EQ(changes.size(), 3);
+    EXPECT_EQ(changes[0].side, kc::DEPTH_SIDE::BUY);
+    EXPECT_EQ(changes[0].change, kc::DEPTH_CHANGE::MODIFIED);
+    EXPECT_EQ(changes[0].level, 0);
+    EXPECT_EQ(changes[0].quantityDelta, 5);
+    EXPECT_EQ(changes[1].side, kc::DEPTH_SIDE::BUY);
+    EXPECT_EQ(changes[1].change, kc::DEPTH_CHANGE::REMOVED);
+    EXPECT_EQ(changes[1].price, price(100));
+    EXPECT_EQ(changes[1].quantityDelta, -10);
+    EXPECT_EQ(changes[2].side, kc::DEPTH_SIDE::SELL);
+    EXPECT_EQ(changes[2].change, kc::DEPTH_CHANGE::ADDED);
+    EXPECT_EQ(changes[2].level, 1);
+
+    ASSERT_TRUE(book.getTopOfBook(TOKEN, top));
+    EXPECT_EQ(top.bidPrice, price(99.5));
+    EXPECT_DOUBLE_EQ(top.mid, 100);
+    EXPECT_EQ(top.bidDepth, 25);
+    EXPECT_EQ(top.askDepth, 35);
+
+    // nothing changed
+    changes.clear();
+    book.update(Tick);
+    EXPECT_TRUE(changes.empty());
+
+    kc::tick::m_depth depth;
+    ASSERT_TRUE(book.getDepth(TOKEN, depth));
+    EXPECT_EQ(depth.buy[0].quantity, 25);
+    EXPECT_EQ(depth.sell[1].price, price(101));
+    EXPECT_FALSE(book.getDepth(TOKEN + 1, depth));
+
+    Tick.marketDepth.count = 0;
+    Tick.instrumentToken = TOKEN + 1;
+    book.update(Tick);
+    EXPECT_FALSE(book.getTopOfBook(TOKEN + 1, top));
+};
+
+TEST(tickerTest, statsTest) {
+    kc::latencyHistogram histogram;
+    EXPECT_EQ(histogram.percentile(50), 0);
+    for (uint64_t i = 1; i <= 1000; i++) { histogram.record(i); };
+    EXPECT_EQ(histogram.count(), 1000);
+    EXPECT_EQ(histogram.min(), 1);
+    EXPECT_EQ(histogram.max(), 1000);
+    EXPECT_DOUBLE_EQ(histogram.mean(), 500.5);
+    EXPECT_EQ(histogram.percentile(1), 10);
+    EXPECT_NEAR(histogram.percentile(50), 500, 500 / 16);
+    EXPECT_NEAR(histogram.percentile(99), 990, 990 / 16);
+    EXPECT_EQ(histogram.percentile(100), 1000);
+    histogram.reset();
+    EXPECT_EQ(histogram.count(), 0);
+
+#ifndef KITE_DISABLE_TICKER_STATS
+    kc::ticker Ticker("apikey123");
+    std::vector<char> data = loadTicksFrame();
+    constexpr auto CALLBACK_TIME = std::chrono::milliseconds(2);
+    Ticker.onTicks = [&](kc::ticker* /*ws*/,
+                         const std::vector<kc::tick>& /*ticks*/) {
+        std::this_thread::sleep_for(CALLBACK_TIME);
+    };
+    Ticker.processBinaryMessage(data.data(), data.size());
+
+    const kc::tickerStats& stats = Ticker.getStats();
+    EXPECT_EQ(stats.frameSize.max(), data.size());
+    EXPECT_EQ(stats.packetCount.count(), 1);
+    EXPECT_EQ(stats.packetCount.max(), Ticker.parseBinaryMessage(
+                                           data.data(), data.size())
+                                           .size());
+    EXPECT_GE(stats.callbackTime.min(),
+        std::chrono::nanoseconds(CALLBACK_TIME).count() * 15 / 16);
+    EXPECT_EQ(stats.parseTime.count(), 1);
+    EXPECT_LT(stats.parseTime.max(), stats.callbackTime.min());
+    EXPECT_NE(stats.lastReceiveTime.load(), 0);
+    const auto lagCount = [&]() {
+        uint64_t count = 0;
+        for (const kc::latencyHistogram& lag : stats.exchangeLag) {
+            count += lag.count();
+        };
+        return count;
+    };
+    const uint64_t lagged = lagCount();
+    EXPECT_GT(lagged, 0);
+
+    // the lag is only sampled from one in every few frames
+    Ticker.onTicks = nullptr;
+    for (uint64_t i = 1; i < kc::tickerStats::EXCHANGE_LAG_SAMPLE_INTERVAL;
+         i++) {
+        Ticker.processBinaryMessage(data.data(), data.size());
+    };
+    EXPECT_EQ(lagCount(), lagged);
+    Ticker.processBinaryMessage(data.data(), data.size());
+    EXPECT_EQ(lagCount(), 2 * lagged);
+
+    Ticker.resetStats();
+    EXPECT_EQ(stats.frameSize.count(), 0);
+#endif
+};
+
+TEST(tickerTest, orderUpdateTest) {
+    EXPECT_EQ(kc::ticker::messageType(R"({"type": "order"})", 17), "order");
+    const string spaced = R"({ "data": {}, "type" :"message" })";
+    EXPECT_EQ(kc::ticker::messageType(spaced.data(), spaced.size()), "message");
+    const string untyped = R"({"order_type":"LIMIT"})";
+    EXPECT_EQ(kc::ticker::messageType(untyped.data(), untyped.size()), "");
+    // nested keys and strings aren't the type of the frame
+    const string nested =
+        R"({"data":{"meta":{"type":"x"},"tag":"\"type\":\"y\""},)"
+        R"( "type":"order"})";
+    EXPECT_EQ(kc::ticker::messageType(nested.data(), nested.size()), "order");
+    const string nestedOnly = R"({"data":{"type":"order"}})";
+    EXPECT_EQ(
+        kc::ticker::messageType(nestedOnly.data(), nestedOnly.size()), "");
+
+    const string order =
+        R"({"type":"order","data":{"order_id":"220303000308932",)"
+        R"("exchange_order_id":null,"status":"COMPLETE",)"
+        R"("tradingsymbol":"INFY","exchange":"NSE","order_type":"LIMIT",)"
+        R"("transaction_type":"BUY","product":"CNC","price":1500.5,)"
+        R"("average_price":1500,"quantity":10,"filled_quantity":10,)"
+        R"("unfilled_quantity":0,"user_id":"AB1234",)"
+        R"("order_timestamp":"2022-03-03 09:15:00"}})";
+    kc::ticker Ticker("apikey123");
+    // skipped without being parsed while nothing consumes order updates
+    const string malformed = R"({"type":"order","data":{)";
+    EXPECT_NO_THROW(
+        Ticker.processTextMessage(malformed.data(), malformed.size()));
+
+    size_t views = 0;
+    kc::postback copied;
+    Ticker.onOrderUpdateView = [&](kc::ticker* /*ws*/,
+                                   const kc::postbackView& postback) {
+        views++;
+        EXPECT_EQ(postback.orderId, "220303000308932");
+        EXPECT_EQ(postback.exchangeOrderId, "");
+        EXPECT_EQ(postback.status, "COMPLETE");
+        EXPECT_EQ(postback.tradingSymbol, "INFY");
+        EXPECT_EQ(postback.transactionType, "BUY");
+        EXPECT_DOUBLE_EQ(postback.price, 1500.5);
+        EXPECT_DOUBLE_EQ(postback.averagePrice, 1500);
+        EXPECT_EQ(postback.quantity, 10);
+        EXPECT_EQ(postback.unfilledQuantity, 0);
+        EXPECT_DOUBLE_EQ(postback.triggerPrice, -1);
+        EXPECT_EQ(postback.orderTimestamp, "2022-03-03 09:15:00");
+    };
+    Ticker.onOrderUpdate = [&](kc::ticker* /*ws*/,
+                               const kc::postback& postback) {
+        copied = postback;
+    };
+    Ticker.processTextMessage(order.data(), order.size());
+    EXPECT_EQ(views, 1);
+    EXPECT_EQ(copied.orderId, "220303000308932");
+    EXPECT_EQ(copied.quantity, 10);
+    EXPECT_THROW(Ticker.processTextMessage(malformed.data(), malformed.size()),
+        kc::libException);
+
+    // the reused buffers hold the previous frame, a shorter one must parse
+    const string shorter = R"({"type":"order","data":{"order_id":"1"}})";
+    Ticker.onOrderUpdate = nullptr;
+    Ticker.onOrderUpdateView = [&](kc::ticker* /*ws*/,
+                                   const kc::postbackView& postback) {
+        EXPECT_EQ(postback.orderId, "1");
+        EXPECT_EQ(postback.status, "");
+    };
+    Ticker.processTextMessage(shorter.data(), shorter.size());
+
+    // only order updates and errors need a body
+    size_t messages = 0;
+    Ticker.onMessage = [&](kc::ticker* /*ws*/, const string& /*message*/) {
+        messages++;
+    };
+    const string bodiless = R"({"type":"message"})";
+    EXPECT_NO_THROW(
+        Ticker.processTextMessage(bodiless.data(), bodiless.size()));
+    EXPECT_EQ(messages, 1);
+    const string unknown = R"({"type":"instruments_meta"})";
+    EXPECT_NO_THROW(Ticker.processTextMessage(unknown.data(), unknown.size()));
+    const string bodilessOrder = R"({"type":"order"})";
+    EXPECT_THROW(Ticker.processTextMessage(
+                     bodilessOrder.data(), bodilessOrder.size()),
+        kc::libException);
+
+    // a type key in the payload ahead of the frame's own doesn't drop it
+    size_t delivered = 0;
+    Ticker.onOrderUpdateView = [&](kc::ticker* /*ws*/,
+                                   const kc::postbackView& postback) {
+        delivered++;
+        EXPECT_EQ(postback.orderId, "2");
+    };
+    const string meta =
+        R"({"data":{"meta":{"type":"x"},"order_id":"2"},"type":"order"})";
+    Ticker.processTextMessage(meta.data(), meta.size());
+    EXPECT_EQ(delivered, 1);
+};
+
+TEST(tickerTest, priceTest) {
+    // the last byte of an instrument token is its segment
+    constexpr int64_t NSE_TOKEN = (1234 << 8) | 1;
+    constexpr int64_t CDS_TOKEN = (1234 << 8) | 3;
+    constexpr int64_t BSECDS_TOKEN = (1234 << 8) | 6;
+    EXPECT_EQ(kc::priceScale(NSE_TOKEN), 100);
+    EXPECT_EQ(kc::priceScale(CDS_TOKEN), 10000000);
+    EXPECT_EQ(kc::priceScale(BSECDS_TOKEN), 10000);
+
+    EXPECT_DOUBLE_EQ(
+        kc::toDouble(kc::toPrice(1234.55, NSE_TOKEN), NSE_TOKEN), 1234.55);
+    EXPECT_DOUBLE_EQ(
+        kc::toDouble(kc::toPrice(74.1234567, CDS_TOKEN), CDS_TOKEN),
+        74.1234567);
+#ifdef KITE_FIXED_POINT_PRICES
+    EXPECT_EQ(kc::toPrice(1234.55, NSE_TOKEN), 123455);
+    EXPECT_EQ(kc::toPrice(74.1234567, CDS_TOKEN), 741234567);
+#endif
+};
+
+TEST(tickerTest, depthDecodingTest) {
+    namespace depth = kc::internal::depth;
+    constexpr size_t DEPTH_SIZE = depth::LEVELS * depth::ENTRY_SIZE;
+    std::mt19937 rng(42); // NOLINT(cert-msc32-c, cert-msc51-cpp)
+    std::uniform_int_distribution<int> byte(0, 255);
+
+    std::vector<depth::decoder> decoders { depth::selectDecoder() };
+#ifdef KITE_DEPTH_SIMD
+    if (__builtin_cpu_supports("sse4.1")) {
+        decoders.push_back(depth::decodeSSE41);
+    };
+    if (__builtin_cpu_supports("avx2")) {
+        decoders.push_back(depth::decodeAVX2);
+    };
+#endif
+
+    for (const double divisor : { 100.0, 10000.0, 10000000.0 }) {
+        std::vector<char> bytes(DEPTH_SIZE);
+        for (auto& b : bytes) { b = static_cast<char>(byte(rng)); };
+
+        depth::levels expected;
+        depth::decodeScalar(bytes.data(), divisor, expected);
+        for (const auto decode : decoders) {
+            depth::levels actual;
+            decode(bytes.data(), divisor, actual);
+            for (size_t i = 0; i < depth::LEVELS; i++) {
+                EXPECT_EQ(actual[i].quantity, expected[i].quantity);
+                EXPECT_EQ(actual[i].orders, expected[i].orders);
+                EXPECT_DOUBLE_EQ(actual[i].price, expected[i].price);
+            };
+        };
+    };
+};
+
+TEST(tickerTest, requestCoalescingTest) {
+    kc::ticker Ticker("apiKey");
+    std::vector<string> frames;
+    const auto send = [&](const char* data, size_t size) {
+        frames.emplace_back(data, size);
+    };
+
+    // requests aren't sent while disconnected
+    EXPECT_THROW(Ticker.subscribe({ 408065 }), kc::libException);
+    EXPECT_THROW(Ticker.setMode(kc::MODE_FULL, { 408065 }), kc::libException);
+
+    using REQUEST = kc::ticker::REQUEST;
+    using MODES = kc::ticker::MODES;
+    Ticker.queueRequest(REQUEST::SUBSCRIBE, { 408065, 2953217, 884737 });
+    Ticker.queueRequest(REQUEST::MODE, { 408065, 884737 }, MODES::FULL);
+    Ticker.queueRequest(REQUEST::MODE, { 884737 }, MODES::LTP);
+    Ticker.queueRequest(REQUEST::UNSUBSCRIBE, { 2953217, 738561 });
+    Ticker.queueRequest(REQUEST::SUBSCRIBE, { 738561 });
+    EXPECT_TRUE(Ticker.requestTimer.isActive());
+    Ticker.encodeRequests(send);
+
+    const std::vector<string> expected {
+        R"({"a":"unsubscribe","v":[2953217,738561]})",
+        R"({"a":"subscribe","v":[408065,884737,738561]})",
+        R"({"a":"mode","v":["ltp",[884737]]})",
+        R"({"a":"mode","v":["full",[408065]]})",
+    };
+    EXPECT_EQ(frames, expected);
+    EXPECT_TRUE(Ticker.pendingTokens.empty());
+    EXPECT_TRUE(Ticker.pendingRequests.empty());
+
+    // frames are split before they exceed the size limit
+    frames.clear();
+    Ticker.maxRequestSize = 40;
+    std::vector<int> tokens;
+    for (int tok = 1000000; tok < 1000010; tok++) { tokens.push_back(tok); };
+    Ticker.queueRequest(REQUEST::MODE, tokens, MODES::QUOTE);
+    Ticker.encodeRequests(send);
+
+    std::vector<int> sent;
+    for (const string& frame : frames) {
+        EXPECT_LE(frame.size(), Ticker.maxRequestSize);
+        rj::Document req;
+        req.Parse(frame.c_str());
+        ASSERT_FALSE(req.HasParseError()) << frame;
+        EXPECT_EQ(string(req["a"].GetString()), "mode");
+        EXPECT_EQ(string(req["v"][0U].GetString()), kc::MODE_QUOTE);
+        for (const auto& tok : req["v"][1U].GetArray()) {
+            sent.push_back(tok.GetInt());
+        };
+    };
+    EXPECT_GT(frames.size(), 1U);
+    EXPECT_EQ(sent, tokens);
+};
+
+TEST(tickerTest, resubscribeTest) {
+    kc::ticker Ticker("apiKey");
+    std::vector<string> frames;
+    const auto send = [&](const char* data, size_t size) {
+        frames.emplace_back(data, size);
+    };
+
+    // a new connection subscribes every instrument, then sets their modes
+    using MODES = kc::ticker::MODES;
+    Ticker.subbedInstruments = { { 408065, MODES::FULL },
+        { 884737, MODES::LTP }, { 2953217, MODES::QUOTE },
+        { 738561, MODES::FULL } };
+    Ticker.resubInstruments();
+    Ticker.encodeRequests(send);
+
+    ASSERT_EQ(frames.size(), 4U);
+    rj::Document req;
+    req.Parse(frames[0].c_str());
+    EXPECT_EQ(string(req["a"].GetString()), "subscribe");
+    std::vector<int> subscribed;
+    for (const auto& tok : req["v"].GetArray()) {
+        subscribed.push_back(tok.GetInt());
+    };
+    std::sort(subscribed.begin(), subscribed.end());
+    EXPECT_EQ(subscribed, (std::vector<int> { 408065, 738561, 884737,
+                              2953217 }));
+
+    std::map<string, std::vector<int>> modes;
+    for (size_t i = 1; i < frames.size(); i++) {
+        req.Parse(frames[i].c_str());
+        EXPECT_EQ(string(req["a"].GetString()), "mode");
+        std::vector<int>& tokens = modes[req["v"][0U].GetString()];
+        for (const auto& tok : req["v"][1U].GetArray()) {
+            tokens.push_back(tok.GetInt());
+        };
+        std::sort(tokens.begin(), tokens.end());
+    };
+    const std::map<string, std::vector<int>> expected {
+        { kc::MODE_LTP, { 884737 } }, { kc::MODE_QUOTE, { 2953217 } },
+        { kc::MODE_FULL, { 408065, 738561 } }
+    };
+    EXPECT_EQ(modes, expected);
+    // the modes that were set are kept
+    EXPECT_EQ(Ticker.subbedInstruments.at(408065), MODES::FULL);
+    EXPECT_EQ(Ticker.subbedInstruments.at(884737), MODES::LTP);
+};
+
+TEST(tickerTest, reconnectTest) {
+    constexpr unsigned int maxDelay = 8;
+    constexpr unsigned int maxTries = 4;
+    kc::ticker Ticker("apiKey", 5, true, maxDelay, maxTries);
+    bool failed = false;
+    Ticker.onReconnectFail = [&](kc::ticker* /*ws*/) { failed = true; };
+
+    // attempts are scheduled on the loop instead of blocking it
+    Ticker.reconnect();
+    EXPECT_TRUE(Ticker.reconnectTimer.isActive());
+    EXPECT_TRUE(Ticker.isReconnecting);
+    EXPECT_EQ(Ticker.reconnectTries, 1U);
+    EXPECT_EQ(Ticker.reconnectDelay, 4U);
+
+    // nothing more is scheduled until the pending attempt is made
+    Ticker.reconnect();
+    EXPECT_EQ(Ticker.reconnectTries, 1U);
+
+    for (unsigned int i = 0; i < 100; i++) {
+        const unsigned int delay = Ticker.nextReconnectDelay();
+        EXPECT_GE(delay, 2000U);
+        EXPECT_LE(delay, 4000U);
+    };
+
+    for (unsigned int tries = 2; tries <= maxTries; tries++) {
+        Ticker.reconnectTimer.stop();
+        Ticker.reconnect();
+        EXPECT_EQ(Ticker.reconnectTries, tries);
+        EXPECT_LE(Ticker.reconnectDelay, maxDelay);
+    };
+    EXPECT_FALSE(failed);
+
+    Ticker.reconnectTimer.stop();
+    Ticker.reconnect();
+    EXPECT_TRUE(failed);
+    EXPECT_FALSE(Ticker.isReconnecting);
+    EXPECT_FALSE(Ticker.reconnectTimer.isActive());
+
+    // stopping cancels a pending attempt and every other timer
+    Ticker.reconnectTries = 0;
+    Ticker.reconnect();
+    Ticker.enableConflation(100);
+    Ticker.enableWatchdog();
+    Ticker.stop();
+    EXPECT_FALSE(Ticker.reconnectTimer.isActive());
+    EXPECT_FALSE(Ticker.conflationTimer.isActive());
+    EXPECT_FALSE(Ticker.watchdogTimer.isActive());
+    EXPECT_FALSE(Ticker.requestTimer.isActive());
+    EXPECT_FALSE(Ticker.isReconnecting);
+};
+
+TEST(tickerTest, watchdogTest) {
+    constexpr uint64_t ms = 1000000;
+    kc::ticker Ticker("apiKey");
+    Ticker.enableWatchdog(2000, 3000);
+    EXPECT_TRUE(Ticker.watchdogTimer.isActive());
+    EXPECT_EQ(Ticker.pongTimeout, 2000 * ms);
+    EXPECT_EQ(Ticker.frameTimeout, 3000 * ms);
+
+    // frames have to keep arriving
+    const uint64_t start = kc::tickerStats::now();
+    Ticker.lastBeatTime = start;
+    EXPECT_TRUE(Ticker.isAlive(start + 3000 * ms));
+    EXPECT_FALSE(Ticker.isAlive(start + 3001 * ms));
+
+    // and pings have to be answered in time
+    Ticker.pingSentTime = start + 100 * ms;
+    EXPECT_TRUE(Ticker.isAlive(start + 2100 * ms));
+    EXPECT_FALSE(Ticker.isAlive(start + 2101 * ms));
+
+    // pongs of other pings are ignored
+    const string empty;
+    Ticker.processPong(empty.data(), empty.size(), start + 150 * ms);
+    const string other = std::to_string(start);
+    Ticker.processPong(other.data(), other.size(), start + 150 * ms);
+    EXPECT_EQ(Ticker.getPingRtt().count(), 0U);
+    EXPECT_NE(Ticker.pingSentTime, 0U);
+
+    const string pong = std::to_string(start + 100 * ms);
+    Ticker.processPong(pong.data(), pong.size(), start + 150 * ms);
+    EXPECT_EQ(Ticker.pingSentTime, 0U);
+    ASSERT_EQ(Ticker.getPingRtt().count(), 1U);
+    EXPECT_EQ(Ticker.getPingRtt().min(), 50 * ms);
+    EXPECT_TRUE(Ticker.isAlive(start + 2500 * ms));
+
+    // heartbeats count as frames even when nothing consumes ticks
+    char heartbeat = 0;
+    const uint64_t beforeBeat = kc::tickerStats::now();
+    Ticker.processMessage(&heartbeat, 1, uWS::OpCode::BINARY);
+    EXPECT_GE(Ticker.lastBeatTime, beforeBeat);
+    EXPECT_TRUE(Ticker.isAlive(kc::tickerStats::now()));
+    const auto sinceBeat =
+        std::chrono::system_clock::now() - Ticker.getLastBeatTime();
+    EXPECT_LT(sinceBeat, std::chrono::seconds(1));
+
+    // nothing is watched while disconnected
+    Ticker.watch();
+    EXPECT_EQ(Ticker.getWatchdogTimeoutCount(), 0U);
+
+    Ticker.disableWatchdog();
+    EXPECT_FALSE(Ticker.watchdogTimer.isActive());
+};
+
+TEST(tickerTest, redundantTickerTest) {
+    kc::redundantTicker Ticker("apikey123");
+    const std::vector<int> instruments { 408065, 884737 };
+
+    // both connections are subscribed
+    Ticker.subscribe(instruments);
+    Ticker.setMode(kc::MODE_FULL, { 408065 });
+    for (size_t i = 0; i < kc::redundantTicker::CONNECTIONS; i++) {
+        EXPECT_EQ(Ticker.connection(i).subbedInstruments.size(), 2U);
+        EXPECT_EQ(Ticker.connection(i).subbedInstruments.at(408065),
+            kc::ticker::MODES::FULL);
+    };
+
+    // ticks received on both connections are delivered once
+    std::vector<char> data = loadTicksFrame();
+    size_t received = 0;
+    Ticker.onTicks = [&](kc::redundantTicker* ws,
+                         const std::vector<kc::tick>& ticks) {
+        EXPECT_EQ(ws, &Ticker);
+        received += ticks.size();
+    };
+    size_t failedOver = 0;
+    Ticker.onFailover = [&](kc::redundantTicker* /*ws*/, size_t primary) {
+        EXPECT_EQ(primary, 1U);
+        failedOver++;
+    };
+    Ticker.connect();
+    const std::vector<char> frame = data;
+    Ticker.connection(0).processBinaryMessage(data.data(), data.size());
+    data = frame;
+    Ticker.connection(1).processBinaryMessage(data.data(), data.size());
+    data = frame;
+    const std::vector<kc::tick> ticks =
+        Ticker.connection(0).parseBinaryMessage(data.data(), data.size());
+    EXPECT_EQ(received, ticks.size());
+    EXPECT_EQ(Ticker.getDuplicateCount(), ticks.size());
+
+    // ticks are compared by exchange timestamp and volume
+    kc::tick Tick;
+    Tick.instrumentToken = 1;
+    Tick.timestamp = 100;
+    Tick.volumeTraded = 10;
+    EXPECT_TRUE(Ticker.isFresh(Tick, 0, 1));
+    EXPECT_FALSE(Ticker.isFresh(Tick, 1, 1));
+    Tick.volumeTraded = 11;
+    EXPECT_TRUE(Ticker.isFresh(Tick, 1, 1));
+    Tick.volumeTraded = 10;
+    EXPECT_FALSE(Ticker.isFresh(Tick, 0, 1));
+    Tick.timestamp = 101;
+    EXPECT_TRUE(Ticker.isFresh(Tick, 0, 1));
+
+    // ticks without either are compared by price, an echo from the other
+    // connection is a duplicate only within the window
+    const uint64_t window = kc::redundantTicker::LTP_WINDOW * 1000000;
+    kc::tick ltp;
+    ltp.instrumentToken = 2;
+    ltp.lastPrice = 100;
+    EXPECT_TRUE(Ticker.isFresh(ltp, 1, 1));
+    EXPECT_FALSE(Ticker.isFresh(ltp, 0, 2));
+    ltp.lastPrice = 101;
+    EXPECT_TRUE(Ticker.isFresh(ltp, 0, 3));
+    // a price can come back on the connection that's ahead
+    ltp.lastPrice = 100;
+    EXPECT_TRUE(Ticker.isFresh(ltp, 0, 4));
+    EXPECT_FALSE(Ticker.isFresh(ltp, 1, 5));
+    ltp.lastPrice = 101;
+    EXPECT_FALSE(Ticker.isFresh(ltp, 1, window + 3));
+    EXPECT_TRUE(Ticker.isFresh(ltp, 1, window + 4));
+
+    // a lagging connection delivers nothing twice
+    std::vector<kc::tick> stream;
+    for (int32_t i = 0; i < 4; i++) {
+        kc::tick full;
+        full.instrumentToken = 3;
+        full.timestamp = 200 + i;
+        full.volumeTraded = 1000 + i;
+        full.lastPrice = 100 + i;
+        stream.push_back(full);
+        kc::tick quote;
+        quote.instrumentToken = 4;
+        quote.lastPrice = 100 + i;
+        stream.push_back(quote);
+    };
+    std::vector<kc::Price> delivered3;
+    std::vector<kc::Price> delivered4;
+    Ticker.onTicks = [&](kc::redundantTicker* /*ws*/,
+                         const std::vector<kc::tick>& Ticks) {
+        for (const kc::tick& received : Ticks) {
+            auto& prices =
+                (received.instrumentToken == 3) ? delivered3 : delivered4;
+            prices.push_back(received.lastPrice);
+        };
+    };
+    // the standby is two ticks ahead of the primary
+    for (size_t i = 0; i < stream.size() + 4; i++) {
+        if (i < stream.size()) { Ticker.deliver({ stream[i] }, 1); };
+        if (i >= 4) { Ticker.deliver({ stream[i - 4] }, 0); };
+    };
+    const std::vector<kc::Price> ordered { 100, 101, 102, 103 };
+    EXPECT_EQ(delivered3, ordered);
+    EXPECT_EQ(delivered4, ordered);
+
+    // the standby takes over when the primary is closed
+    EXPECT_EQ(Ticker.primary(), 0U);
+    Ticker.connection(0).onClose(&Ticker.connection(0), 1006, "");
+    EXPECT_EQ(Ticker.primary(), 1U);
+    EXPECT_EQ(failedOver, 1U);
+    Ticker.connection(0).onClose(&Ticker.connection(0), 1006, "");
+    EXPECT_EQ(failedOver, 1U);
+};
+
+TEST(tickerTest, commandQueueTest) {
+    // commands pushed from many threads are run in the order each thread
+    // pushed them
+    constexpr int producers = 4;
+    constexpr int perProducer = 10000;
+    kc::internal::commandQueue queue;
+    std::vector<std::vector<int>> seen(producers);
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; p++) {
+        threads.emplace_back([&queue, &seen, p]() {
+            for (int i = 0; i < perProducer; i++) {
+                queue.push([&seen, p, i]() { seen[p].push_back(i); });
+            };
+        });
+    };
+    size_t ran = 0;
+    while (ran < static_cast<size_t>(producers * perProducer)) {
+        queue.run();
+        ran = 0;
+        for (const auto& values : seen) { ran += values.size(); };
+    };
+    for (auto& thread : threads) { thread.join(); };
+    for (const auto& values : seen) {
+        ASSERT_EQ(values.size(), static_cast<size_t>(perProducer));
+        EXPECT_TRUE(std::is_sorted(values.begin(), values.end()));
+    };
+
+    // calls from other threads are made on the loop and report failures
+    kc::ticker Ticker("apikey123");
+    Ticker.connect();
+    EXPECT_TRUE(Ticker.commands.isActive());
+    std::future<void> subscribed;
+    std::thread([&]() { subscribed = Ticker.subscribeAsync({ 408065 }); })
+        .join();
+    std::future<void> modeSet = Ticker.setModeAsync(kc::MODE_FULL, { 408065 });
+    // what the loop does once it's woken, the loop isn't running here
+    Ticker.commands.run();
+    ASSERT_EQ(subscribed.wait_for(std::chrono::milliseconds(0)),
+        std::future_status::ready);
+    EXPECT_THROW(subscribed.get(), kc::libException);
+    ASSERT_EQ(modeSet.wait_for(std::chrono::milliseconds(0)),
+        std::future_status::ready);
+    EXPECT_THROW(modeSet.get(), kc::libException);
+
+    // once stopped, calls are rejected
+    Ticker.stop();
+    EXPECT_FALSE(Ticker.commands.isActive());
+    std::future<void> unsubscribed = Ticker.unsubscribeAsync({ 408065 });
+    ASSERT_EQ(unsubscribed.wait_for(std::chrono::milliseconds(0)),
+        std::future_status::ready);
+    EXPECT_THROW(unsubscribed.get(), kc::libException);
+
+    // run() returns once the server closes the connection for good, nothing
+    // keeps the loop running
+    kc::ticker Final("apikey123", 5, false);
+    Final.connect();
+    Final.enableWatchdog();
+    Final.processDisconnection(1006, "going away");
+    EXPECT_FALSE(Final.commands.isActive());
+    EXPECT_FALSE(Final.watchdogTimer.isActive());
+    EXPECT_NO_THROW(Final.run());
+
+    // or once it gives up reconnecting
+    kc::ticker GivingUp("apikey123", 5, true, 5, 0);
+    bool connectedAgain = false;
+    GivingUp.onReconnectFail = [&](kc::ticker* ws) {
+        // may connect again from the callback
+        ws->connect();
+        connectedAgain = ws->commands.isActive();
+        ws->stop();
+    };
+    GivingUp.connect();
+    GivingUp.processDisconnection(1006, "going away");
+    EXPECT_TRUE(connectedAgain);
+    EXPECT_FALSE(GivingUp.commands.isActive());
+    EXPECT_FALSE(GivingUp.reconnectTimer.isActive());
+    EXPECT_NO_THROW(GivingUp.run());
+};
+
+struct countingListener : kc::tickerListener<countingListener> {
+    size_t ticks = 0;
+    size_t connects = 0;
+
+    void onTicks(kc::ticker* /*ws*/, const std::vector<kc::tick>& Ticks) {
+        ticks += Ticks.size();
+    };
+
+    void onConnect(kc::ticker* /*ws*/) { connects++; };
+};
+
+TEST(tickerTest, listenerTest) {
+    using handlers = kc::internal::listenerHandlers<countingListener>;
+    static_assert(handlers::ON_TICKS && handlers::ON_CONNECT);
+    static_assert(!handlers::ON_TICK_VIEWS && !handlers::ON_ORDER_UPDATE &&
+                  !handlers::ON_CLOSE);
+
+    kc::ticker Ticker("apikey123");
+    countingListener listener;
+    Ticker.connect(listener);
+
+    // handlers the listener defines are also set as callbacks, the others
+    // are left unset
+    ASSERT_TRUE(Ticker.onConnect);
+    Ticker.onConnect(&Ticker);
+    EXPECT_EQ(listener.connects, 1U);
+    EXPECT_FALSE(Ticker.onTickViews);
+    EXPECT_FALSE(Ticker.onClose);
+
+    // ticks are delivered to the listener directly
+    std::vector<char> data = loadTicksFrame();
+    const std::vector<kc::tick> ticks =
+        Ticker.parseBinaryMessage(data.data(), data.size());
+    const kc::ticker::listenerCallbacks<countingListener> callbacks {
+        &Ticker, &listener
+    };
+    static_assert(callbacks.hasTicks() && !callbacks.hasTickBatch());
+    EXPECT_TRUE(Ticker.hasTickConsumers(callbacks));
+    Ticker.processMessage(
+        data.data(), data.size(), uWS::OpCode::BINARY, callbacks);
+    EXPECT_EQ(listener.ticks, ticks.size());
+
+    // and through the callbacks on other paths
+    Ticker.processBinaryMessage(data.data(), data.size());
+    EXPECT_EQ(listener.ticks, 2 * ticks.size());
+};
+
 } // namespace kiteconnect